@@ -6,6 +6,7 @@
 #include "wayfire/seat.hpp"
 #include "wayfire/signal-definitions.hpp"
 #include <wayfire/util/log.hpp>
+#include <algorithm>
 #include <cmath>
 #include <wayfire/view-transform.hpp>
 #include <wayfire/util/duration.hpp>
@@ -14,6 +15,7 @@
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/plugins/common/util.hpp>
 #include <wayfire/plugins/wobbly/wobbly-signal.hpp>
+#include <wayfire/output.hpp>
 #include <wayfire/output-layout.hpp>
 #include <wayfire/render-manager.hpp>
 #include <wayfire/nonstd/observer_ptr.h>
@@ -159,9 +161,25 @@ class dragged_view_node_t : public wf::scene::node_t
 {
   public:
     std::vector<dragged_view_t> views;
-    dragged_view_node_t(std::vector<dragged_view_t> views) : node_t(false)
+
+    // Whether the views are rendered from snapshots, see drag_options_t::snapshot.
+    bool snapshot;
+
+    // In snapshot mode, the render instances of the content of each view below its drag transformer. They are
+    // rendered into the transformer's buffer, which is then drawn at the drag position on every output.
+    std::vector<std::unique_ptr<wf::scene::render_instance_manager_t>> snapshots;
+
+    // In snapshot mode, the last bounding box used for damage.
+    wf::geometry_t last_bbox = {0, 0, 0, 0};
+
+    dragged_view_node_t(std::vector<dragged_view_t> views, bool snapshot) : node_t(false)
     {
-        this->views = views;
+        this->views    = views;
+        this->snapshot = snapshot;
+        if (snapshot)
+        {
+            create_snapshots();
+        }
     }
 
     std::string stringify() const override
@@ -172,6 +190,12 @@ class dragged_view_node_t : public wf::scene::node_t
     void gen_render_instances(std::vector<scene::render_instance_uptr>& instances,
         scene::damage_callback push_damage, wf::output_t *output = nullptr) override
     {
+        if (snapshot)
+        {
+            instances.push_back(std::make_unique<snapshot_render_instance_t>(this, push_damage, output));
+            return;
+        }
+
         instances.push_back(std::make_unique<dragged_view_render_instance_t>(
             std::dynamic_pointer_cast<dragged_view_node_t>(shared_from_this()), push_damage, output));
     }
@@ -183,13 +207,112 @@ class dragged_view_node_t : public wf::scene::node_t
         {
             // Note: bbox will be in output layout coordinates now, since this is
             // how the transformer works
-            auto bbox = view.view->get_transformed_node()->get_bounding_box();
+            auto bbox = snapshot ? view.transformer->get_bounding_box() :
+                view.view->get_transformed_node()->get_bounding_box();
             bounding |= bbox;
         }
 
         return wlr_box_from_pixman_box(bounding.get_extents());
     }
 
+    /** In snapshot mode, damage the dragged views after they have been moved or rescaled. */
+    void damage_snapshots()
+    {
+        if (!snapshot)
+        {
+            return;
+        }
+
+        wf::region_t damage{last_bbox};
+        last_bbox = get_bounding_box();
+        damage   |= last_bbox;
+        wf::scene::damage_node(this, damage);
+    }
+
+  private:
+    void create_snapshots()
+    {
+        const int BIG_NUMBER    = 1e5;
+        wf::region_t big_region =
+            wf::geometry_t{-BIG_NUMBER, -BIG_NUMBER, 2 * BIG_NUMBER, 2 * BIG_NUMBER};
+
+        for (auto& view : views)
+        {
+            auto tr = view.transformer;
+            auto on_content_damage = [=] (const wf::region_t& region)
+            {
+                tr->cached_damage |= region;
+                wf::scene::damage_node(this, tr->get_bounding_box());
+            };
+
+            // Frame callbacks and presentation feedback of the view follow its (original) output.
+            auto manager = std::make_unique<wf::scene::render_instance_manager_t>(tr->get_children(),
+                on_content_damage, view.view->get_output());
+            manager->set_visibility_region(big_region);
+            tr->cached_damage |= tr->get_children_bounding_box();
+            snapshots.push_back(std::move(manager));
+        }
+
+        last_bbox = get_bounding_box();
+    }
+
+    class snapshot_render_instance_t : public wf::scene::simple_render_instance_t<dragged_view_node_t>
+    {
+      public:
+        using simple_render_instance_t::simple_render_instance_t;
+
+        void render(const wf::scene::render_instruction_t& data) override
+        {
+            // The first view is on top, so it is drawn last.
+            for (size_t i = self->views.size(); i-- > 0;)
+            {
+                auto& tr = self->views[i].transformer;
+                auto content_box = tr->get_children_bounding_box();
+                if ((content_box.width <= 0) || (content_box.height <= 0))
+                {
+                    continue;
+                }
+
+                float scale = get_snapshot_scale(tr->get_bounding_box());
+                auto& instances = self->snapshots[i]->get_instances();
+                auto tex = tr->get_updated_contents(content_box, scale, instances);
+                data.pass->add_texture(tex, data.target, tr->get_bounding_box(), data.damage,
+                    tr->alpha_factor);
+            }
+        }
+
+        /**
+         * Render snapshots at the highest scale of the outputs the dragged view is shown on, so that it
+         * stays sharp on all of them while it spans outputs with different scales.
+         */
+        static float get_snapshot_scale(wf::geometry_t bbox)
+        {
+            float scale = 0.0;
+            for (auto& wo : wf::get_core().output_layout->get_outputs())
+            {
+                auto overlap = wf::geometry_intersection(wo->get_layout_geometry(), bbox);
+                if ((overlap.width > 0) && (overlap.height > 0))
+                {
+                    scale = std::max(scale, wo->handle->scale);
+                }
+            }
+
+            return (scale > 0) ? scale : 1.0;
+        }
+
+        void presentation_feedback(wf::output_t *output) override
+        {
+            for (auto& snapshot : self->snapshots)
+            {
+                for (auto& instance : snapshot->get_instances())
+                {
+                    instance->presentation_feedback(output);
+                }
+            }
+        }
+    };
+
+  public:
     class dragged_view_render_instance_t : public wf::scene::render_instance_t
     {
         wf::geometry_t last_bbox = {0, 0, 0, 0};
@@ -274,6 +397,10 @@ struct core_drag_t::impl
             if (v.transformer->scale_factor.running())
             {
                 v.view->damage();
+                if (render_node)
+                {
+                    render_node->damage_snapshots();
+                }
             }
         }
     };
@@ -370,14 +497,18 @@ void core_drag_t::start_drag(wayfire_toplevel_view grab_view, wf::pointf_t relat
         rebuild_wobbly(v, *tentative_grab_position, dragged.transformer->relative_grab);
 
         // TODO: make this configurable!
-        start_wobbly_rel(v, dragged.transformer->relative_grab);
+        if (!options.snapshot)
+        {
+            // Wobbly wraps the drag transformer, so it has no effect on snapshots.
+            start_wobbly_rel(v, dragged.transformer->relative_grab);
+        }
 
         priv->all_views.push_back(dragged);
         v->connect(&priv->on_view_unmap);
     }
 
     // Setup overlay hooks
-    priv->render_node = std::make_shared<dragged_view_node_t>(priv->all_views);
+    priv->render_node = std::make_shared<dragged_view_node_t>(priv->all_views, options.snapshot);
     wf::scene::add_front(wf::get_core().scene(), priv->render_node);
     wf::get_core().set_cursor("grabbing");
 
@@ -441,6 +572,11 @@ void core_drag_t::handle_motion(wf::point_t to)
         }
     }
 
+    if (priv->render_node)
+    {
+        priv->render_node->damage_snapshots();
+    }
+
     update_current_output(to);
 
     drag_motion_signal data;
@@ -2,7 +2,13 @@
 
 #include "wayfire/core.hpp"
 #include "wayfire/geometry.hpp"
+#include "wayfire/plugins/common/shared-core-data.hpp"
+#include <list>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <wayfire/config/types.hpp>
 #include <cairo.h>
 #include <pango/pango.h>
@@ -112,6 +118,130 @@ struct owned_texture_t
     wf::dimensions_t size = {0, 0};
 };
 
+/**
+ * A process-wide cache of rasterized text, shared between all plugins which render text (for example
+ * cairo_text_t users, decorations, OSDs).
+ *
+ * Entries are identified by a string key which must describe everything which influences the result,
+ * and are evicted in least-recently-used order once the total size of the textures exceeds the budget.
+ * Textures are reference-counted, so evicting an entry never frees a texture which is still displayed.
+ *
+ * The cache is shared through wf::shared_data::ref_ptr_t, so that it is freed together with its last user
+ * instead of outliving the plugins which filled it.
+ */
+class text_texture_cache_t
+{
+  public:
+    struct entry_t
+    {
+        std::shared_ptr<owned_texture_t> texture;
+        /** The size of the rendered texture, as cairo_text_t::get_size() would return it. */
+        wf::dimensions_t surface_size;
+        /** The size needed by the text, as cairo_text_t::render_text() would return it. */
+        wf::dimensions_t text_size;
+    };
+
+    struct stats_t
+    {
+        uint64_t hits   = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes   = 0;
+        size_t budget  = 0;
+    };
+
+    /** The default budget, 16 MiB, is enough for a few hundred window titles on a HiDPI screen. */
+    static constexpr size_t DEFAULT_BUDGET = 16 << 20;
+
+    /** Find the entry with the given key and mark it as recently used. */
+    std::optional<entry_t> find(const std::string& key)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end())
+        {
+            ++stats.misses;
+            return {};
+        }
+
+        ++stats.hits;
+        lru.splice(lru.begin(), lru, it->second.lru_it);
+        return it->second.entry;
+    }
+
+    /** Add a new entry to the cache, replacing the old entry with the same key, if any. */
+    void insert(const std::string& key, entry_t entry)
+    {
+        erase(key);
+
+        auto size = entry.texture ? entry.texture->get_size() : wf::dimensions_t{0, 0};
+        size_t bytes = 4ul * size.width * size.height;
+
+        lru.push_front(key);
+        entries[key] = {entry, bytes, lru.begin()};
+        stats.bytes += bytes;
+        evict();
+    }
+
+    /** Change the byte budget of the cache, evicting entries if necessary. */
+    void set_budget(size_t bytes)
+    {
+        budget = bytes;
+        evict();
+    }
+
+    /** Drop all entries. Statistics are preserved. */
+    void clear()
+    {
+        entries.clear();
+        lru.clear();
+        stats.bytes = 0;
+    }
+
+    stats_t get_stats() const
+    {
+        auto result = stats;
+        result.entries = entries.size();
+        result.budget  = budget;
+        return result;
+    }
+
+  private:
+    struct stored_entry_t
+    {
+        entry_t entry;
+        size_t bytes;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    /* Most recently used keys are in the front */
+    std::list<std::string> lru;
+    std::unordered_map<std::string, stored_entry_t> entries;
+    size_t budget = DEFAULT_BUDGET;
+    stats_t stats;
+
+    void erase(const std::string& key)
+    {
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            stats.bytes -= it->second.bytes;
+            lru.erase(it->second.lru_it);
+            entries.erase(it);
+        }
+    }
+
+    void evict()
+    {
+        // Always keep the most recent entry, even if it alone exceeds the budget.
+        while ((stats.bytes > budget) && (lru.size() > 1))
+        {
+            erase(lru.back());
+            ++stats.evictions;
+        }
+    }
+};
+
 /**
  * Simple wrapper around rendering text with Cairo. This object can be
  * kept around to avoid reallocation of the cairo surface and OpenGL
@@ -169,10 +299,24 @@ struct cairo_text_t
      */
     wf::dimensions_t render_text(const std::string& text, const params& par)
     {
+        auto& cache = *text_cache.get();
+        auto key    = cache_key(text, par);
+        if (auto cached = cache.find(key))
+        {
+            this->tex = cached->texture;
+            this->surface_size = cached->surface_size;
+            return cached->text_size;
+        }
+
         if (!cr)
         {
-            /* create with default size */
-            cairo_create_surface();
+            /* create with default size, or the size of the last texture taken from the cache */
+            cairo_create_surface((surface_size.width > 0) && (surface_size.height > 0) ?
+                surface_size : default_surface_size);
+        } else if ((cairo_image_surface_get_width(surface) != surface_size.width) ||
+                   (cairo_image_surface_get_height(surface) != surface_size.height))
+        {
+            cairo_create_surface(surface_size);
         }
 
         PangoFontDescription *font_desc;
@@ -266,7 +410,8 @@ struct cairo_text_t
         g_object_unref(layout);
 
         cairo_surface_flush(surface);
-        this->tex = owned_texture_t{surface};
+        this->tex = std::make_shared<owned_texture_t>(surface);
+        cache.insert(key, {this->tex, surface_size, ret});
         return ret;
     }
 
@@ -280,7 +425,7 @@ struct cairo_text_t
     cairo_text_t& operator =(const cairo_text_t&) = delete;
 
     cairo_text_t(cairo_text_t && o) noexcept : cr(o.cr), surface(o.surface),
-        surface_size(o.surface_size), tex(std::move(o.tex))
+        surface_size(o.surface_size), tex(std::move(o.tex)), text_cache(o.text_cache)
     {
         o.cr = nullptr;
         o.surface = nullptr;
@@ -336,7 +481,7 @@ struct cairo_text_t
 
     wf::texture_t get_texture() const
     {
-        return this->tex.get_texture();
+        return tex ? tex->get_texture() : wf::texture_t{nullptr};
     }
 
   protected:
@@ -363,7 +508,9 @@ struct cairo_text_t
         surface = nullptr;
     }
 
-    void cairo_create_surface(wf::dimensions_t size = {400, 100})
+    static constexpr wf::dimensions_t default_surface_size = {400, 100};
+
+    void cairo_create_surface(wf::dimensions_t size = default_surface_size)
     {
         cairo_free();
         this->surface_size = size;
@@ -371,6 +518,30 @@ struct cairo_text_t
         cr = cairo_create(surface);
     }
 
-    owned_texture_t tex;
+    std::string cache_key(const std::string& text, const params& par) const
+    {
+        std::ostringstream key;
+        auto add_color = [&] (const wf::color_t& c)
+        {
+            key << c.r << ',' << c.g << ',' << c.b << ',' << c.a << ';';
+        };
+
+        key << "cairo_text;" << par.font_size << ';' << par.output_scale << ';';
+        add_color(par.bg_color);
+        add_color(par.text_color);
+        key << par.max_size.width << 'x' << par.max_size.height << ';' <<
+            par.bg_rect << par.rounded_rect << par.exact_size << ';';
+        if (!par.exact_size)
+        {
+            /* The result also depends on the size of our current surface */
+            key << surface_size.width << 'x' << surface_size.height << ';';
+        }
+
+        key << text;
+        return key.str();
+    }
+
+    std::shared_ptr<owned_texture_t> tex;
+    wf::shared_data::ref_ptr_t<text_texture_cache_t> text_cache;
 };
 }
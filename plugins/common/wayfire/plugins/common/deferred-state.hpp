@@ -0,0 +1,181 @@
+#pragma once
+
+#include <wayfire/object.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/option-wrapper.hpp>
+#include <wayfire/util/log.hpp>
+#include <wayfire/plugins/common/shared-core-data.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace wf
+{
+class deferred_state_base_t;
+
+/**
+ * Statistics about the deferred state (see deferred_state_t) of all plugins, shared through
+ * wf::shared_data::ref_ptr_t. Sizes are the memory the states report holding themselves, see
+ * deferred_state_t.
+ */
+struct deferred_state_stats_t
+{
+    struct entry_t
+    {
+        /** How many times the state was created. */
+        uint64_t activations = 0;
+        /** How many times the state was released after being idle. */
+        uint64_t releases = 0;
+        /** The deferred states of plugin instances whose state is currently created. */
+        std::set<const deferred_state_base_t*> resident;
+        /** Memory held by the state of instances which have released it when it was released, i.e. memory
+         * saved. */
+        int64_t released_bytes = 0;
+
+        /** @return The memory currently held by the created states. */
+        int64_t get_resident_bytes() const;
+    };
+
+    std::map<std::string, entry_t> plugins;
+};
+
+/** The part of deferred_state_t which does not depend on the type of the state. */
+class deferred_state_base_t
+{
+  public:
+    virtual ~deferred_state_base_t() = default;
+
+    /** @return The memory held by the state, or 0 if it is not created. */
+    virtual int64_t get_memory_usage() const = 0;
+};
+
+inline int64_t deferred_state_stats_t::entry_t::get_resident_bytes() const
+{
+    int64_t bytes = 0;
+    for (auto state : resident)
+    {
+        bytes += state->get_memory_usage();
+    }
+
+    return bytes;
+}
+
+/**
+ * Heavy state of a rarely used plugin (GL programs, textures, large buffers, ...) which is created only when
+ * the plugin is activated for the first time, and released again after the plugin has been idle for
+ * core/plugin_idle_release_timeout milliseconds.
+ *
+ * The plugin keeps registering its bindings in init() as usual, and calls get() whenever it needs the state,
+ * and release_when_idle() when it is deactivated. The destructor of @State must free its resources, for
+ * GL resources within wf::gles::run_in_context_if_gles().
+ *
+ * @State must also provide `int64_t get_memory_usage() const`, returning the bytes it holds, including
+ * textures and buffers in GPU memory, for the statistics. It is queried whenever the statistics are read,
+ * so resources loaded asynchronously after creation are counted once they exist.
+ */
+template<class State>
+class deferred_state_t : public deferred_state_base_t
+{
+  public:
+    using create_t = std::function<std::unique_ptr<State>()>;
+
+    deferred_state_t(std::string plugin_name, create_t create) :
+        plugin_name(std::move(plugin_name)), create(std::move(create))
+    {}
+
+    ~deferred_state_t()
+    {
+        if (state)
+        {
+            get_stats_entry().resident.erase(this);
+        } else
+        {
+            get_stats_entry().released_bytes -= released_size;
+        }
+    }
+
+    deferred_state_t(const deferred_state_t&) = delete;
+    deferred_state_t& operator =(const deferred_state_t&) = delete;
+
+    /** Get the state, creating it if necessary. Cancels a pending release. */
+    State& get()
+    {
+        idle_timer.disconnect();
+        if (!state)
+        {
+            auto& entry = get_stats_entry();
+            entry.released_bytes -= released_size;
+            released_size = 0;
+
+            state = create();
+            ++entry.activations;
+            entry.resident.insert(this);
+            LOGD(plugin_name, ": created deferred state");
+        }
+
+        return *state;
+    }
+
+    /** @return The state if it has been created, or nullptr otherwise. Does not create the state. */
+    State *get_if_created() const
+    {
+        return state.get();
+    }
+
+    /** Release the state once the plugin has not used it for the configured idle period. */
+    void release_when_idle()
+    {
+        if (!state || (idle_release_timeout <= 0))
+        {
+            return;
+        }
+
+        idle_timer.set_timeout(idle_release_timeout, [=] { release(); });
+    }
+
+    /** Release the state immediately. */
+    void release()
+    {
+        idle_timer.disconnect();
+        if (!state)
+        {
+            return;
+        }
+
+        released_size = state->get_memory_usage();
+        state.reset();
+
+        auto& entry = get_stats_entry();
+        ++entry.releases;
+        entry.resident.erase(this);
+        entry.released_bytes += released_size;
+        LOGD(plugin_name, ": released deferred state after being idle, ", released_size / 1024, " KiB");
+    }
+
+    int64_t get_memory_usage() const override
+    {
+        return state ? state->get_memory_usage() : 0;
+    }
+
+  private:
+    std::string plugin_name;
+    create_t create;
+    std::unique_ptr<State> state;
+    // The memory held by the state when it was last released, while it is not created.
+    int64_t released_size = 0;
+
+    wf::wl_timer<false> idle_timer;
+    wf::option_wrapper_t<int> idle_release_timeout{"core/plugin_idle_release_timeout"};
+    wf::shared_data::ref_ptr_t<deferred_state_stats_t> stats;
+
+    deferred_state_stats_t::entry_t& get_stats_entry()
+    {
+        return stats->plugins[plugin_name];
+    }
+};
+}
@@ -105,6 +105,20 @@ class input_grab_t
 {
     wf::output_t *output;
     std::shared_ptr<scene::grab_node_t> grab_node;
+    scene::node_flags_bitmask_t additional_flags = 0;
+
+    void set_additional_flag(scene::node_flags flag, bool enabled)
+    {
+        if (enabled)
+        {
+            additional_flags |= (uint64_t)flag;
+        } else
+        {
+            additional_flags &= ~(uint64_t)flag;
+        }
+
+        grab_node->set_additional_flags(additional_flags);
+    }
 
   public:
     input_grab_t(std::string name, wf::output_t *output,
@@ -121,7 +135,16 @@ class input_grab_t
      */
     void set_wants_raw_input(bool wants_raw)
     {
-        grab_node->set_additional_flags(wants_raw ? (uint64_t)wf::scene::node_flags::RAW_INPUT : 0);
+        set_additional_flag(wf::scene::node_flags::RAW_INPUT, wants_raw);
+    }
+
+    /**
+     * Set/unset the COALESCE_MOTION flag on the grab node, so that pointer motion is delivered at most once
+     * per frame. Clients, including those using relative pointer, still receive every motion event.
+     */
+    void set_coalesce_motion(bool coalesce)
+    {
+        set_additional_flag(wf::scene::node_flags::COALESCE_MOTION, coalesce);
     }
 
     bool is_grabbed() const
@@ -148,6 +148,14 @@ struct drag_options_t
     bool join_views = false;
 
     double initial_scale = 1.0;
+
+    /**
+     * Render each dragged view from a snapshot of its contents, which is updated only where the view is
+     * damaged, instead of rendering it through all of its transformers on every frame and output. This makes
+     * dragging large views across outputs cheap, but effects above the drag transformer (e.g. wobbly) are
+     * not shown while dragging.
+     */
+    bool snapshot = false;
 };
 
 /**
@@ -2,6 +2,7 @@
 #define WF_CUBE_BACKGROUND_HPP
 
 #include <wayfire/opengl.hpp>
+#include <cstdint>
 #include "cube.hpp"
 
 class wf_cube_background_base
@@ -10,6 +11,12 @@ class wf_cube_background_base
     virtual void render_frame(const wf::render_target_t& fb,
         wf_cube_animation_attribs& attribs) = 0;
     virtual ~wf_cube_background_base() = default;
+
+    /** @return The memory held by the textures and vertex data of the background, in bytes. */
+    virtual int64_t get_memory_usage() const
+    {
+        return 0;
+    }
 };
 
 #endif /* end of include guard: WF_CUBE_BACKGROUND_HPP */
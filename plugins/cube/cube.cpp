@@ -9,6 +9,7 @@
 #include <wayfire/workspace-set.hpp>
 #include <wayfire/scene-operations.hpp>
 #include <wayfire/plugins/common/input-grab.hpp>
+#include <wayfire/plugins/common/deferred-state.hpp>
 #include "wayfire/plugins/ipc/ipc-activator.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -37,6 +38,31 @@
 #include "shaders.tpp"
 #include "shaders-3-2.tpp"
 
+/** The GL resources of the cube, created on the first activation, see wf::deferred_state_t. */
+struct cube_gl_state_t
+{
+    OpenGL::program_t program;
+    bool tessellation_support = false;
+
+    std::string background_mode;
+    std::unique_ptr<wf_cube_background_base> background;
+
+    /** The compiled programs are not counted, as GL does not report their size. */
+    int64_t get_memory_usage() const
+    {
+        return background ? background->get_memory_usage() : 0;
+    }
+
+    ~cube_gl_state_t()
+    {
+        background.reset();
+        wf::gles::run_in_context_if_gles([&]
+        {
+            program.free_resources();
+        });
+    }
+};
+
 class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer_interaction_t
 {
     class cube_render_node_t : public wf::scene::node_t
@@ -185,45 +211,53 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
      * for the given FOV */
     float identity_z_offset;
 
-    OpenGL::program_t program;
-
     wf_cube_animation_attribs animation;
     wf::option_wrapper_t<bool> use_light{"cube/light"};
     wf::option_wrapper_t<int> use_deform{"cube/deform"};
 
-    std::string last_background_mode;
-    std::unique_ptr<wf_cube_background_base> background;
-
     wf::option_wrapper_t<std::string> background_mode{"cube/background_mode"};
 
-    void reload_background()
+    /* Shaders and backgrounds are created only when the cube is first used, and released again when it
+     * has not been used for a while. */
+    wf::deferred_state_t<cube_gl_state_t> gl{"cube", [=] { return create_gl_state(); }};
+
+    std::unique_ptr<cube_gl_state_t> create_gl_state()
+    {
+        auto state = std::make_unique<cube_gl_state_t>();
+        wf::gles::run_in_context([&]
+        {
+            load_program(*state);
+        });
+        reload_background(*state);
+        return state;
+    }
+
+    void reload_background(cube_gl_state_t& state)
     {
-        if (last_background_mode == (std::string)background_mode)
+        if (state.background_mode == (std::string)background_mode)
         {
             return;
         }
 
-        last_background_mode = background_mode;
+        state.background_mode = background_mode;
 
-        if (last_background_mode == "simple")
+        if (state.background_mode == "simple")
         {
-            background = std::make_unique<wf_cube_simple_background>();
-        } else if (last_background_mode == "skydome")
+            state.background = std::make_unique<wf_cube_simple_background>();
+        } else if (state.background_mode == "skydome")
         {
-            background = std::make_unique<wf_cube_background_skydome>(output);
-        } else if (last_background_mode == "cubemap")
+            state.background = std::make_unique<wf_cube_background_skydome>(output);
+        } else if (state.background_mode == "cubemap")
         {
-            background = std::make_unique<wf_cube_background_cubemap>();
+            state.background = std::make_unique<wf_cube_background_cubemap>();
         } else
         {
             LOGE("cube: Unrecognized background mode %s. Using default \"simple\"",
-                last_background_mode.c_str());
-            background = std::make_unique<wf_cube_simple_background>();
+                state.background_mode.c_str());
+            state.background = std::make_unique<wf_cube_simple_background>();
         }
     }
 
-    bool tessellation_support;
-
     int get_num_faces()
     {
         return output->wset()->get_workspace_grid_size().width;
@@ -248,14 +282,9 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
         animation.cube_animation.ease_deformation.set(0, 0);
 
         animation.cube_animation.start();
-
-        reload_background();
+        animation.projection = glm::perspective(45.0f, 1.f, 0.1f, 100.f);
 
         output->connect(&on_cube_control);
-        wf::gles::run_in_context([&]
-        {
-            load_program();
-        });
     }
 
     void handle_pointer_button(const wlr_pointer_button_event& event) override
@@ -274,19 +303,19 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
         }
     }
 
-    void load_program()
+    void load_program(cube_gl_state_t& state)
     {
 #ifdef USE_GLES32
         std::string ext_string(reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS)));
-        tessellation_support = ext_string.find(std::string("GL_EXT_tessellation_shader")) !=
+        state.tessellation_support = ext_string.find(std::string("GL_EXT_tessellation_shader")) !=
             std::string::npos;
 #else
-        tessellation_support = false;
+        state.tessellation_support = false;
 #endif
 
-        if (!tessellation_support)
+        if (!state.tessellation_support)
         {
-            program.set_simple(OpenGL::compile_program(cube_vertex_2_0, cube_fragment_2_0));
+            state.program.set_simple(OpenGL::compile_program(cube_vertex_2_0, cube_fragment_2_0));
         } else
         {
 #ifdef USE_GLES32
@@ -313,11 +342,9 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
             GL_CALL(glDeleteShader(tcs));
             GL_CALL(glDeleteShader(tes));
             GL_CALL(glDeleteShader(gss));
-            program.set_simple(id);
+            state.program.set_simple(id);
 #endif
         }
-
-        animation.projection = glm::perspective(45.0f, 1.f, 0.1f, 100.f);
     }
 
     wf::signal::connection_t<cube_control_signal> on_cube_control = [=] (cube_control_signal *d)
@@ -387,7 +414,7 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
             identity_z_offset = 0.0f;
         }
 
-        reload_background();
+        reload_background(gl.get());
         animation.cube_animation.offset_z.set(identity_z_offset + Z_OFFSET_NEAR,
             identity_z_offset + Z_OFFSET_NEAR);
         return true;
@@ -427,6 +454,7 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
         auto cws = output->wset()->get_current_workspace();
         int nvx  = (cws.x + (dvx % size) + size) % size;
         output->wset()->set_workspace({nvx, cws.y});
+        gl.release_when_idle();
 
         /* We are finished with rotation, make sure the next time cube is used
          * it is properly reset */
@@ -583,7 +611,7 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
     }
 
     /* Render the sides of the cube, using the given culling mode - cw or ccw */
-    void render_cube(GLuint front_face, std::vector<wf::auxilliary_buffer_t>& buffers)
+    void render_cube(cube_gl_state_t& state, GLuint front_face, std::vector<wf::auxilliary_buffer_t>& buffers)
     {
         GL_CALL(glFrontFace(front_face));
         static const GLuint indexData[] = {0, 1, 2, 0, 2, 3};
@@ -595,9 +623,9 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
             GL_CALL(glBindTexture(GL_TEXTURE_2D, wf::gles_texture_t::from_aux(buffers[index]).tex_id));
 
             auto model = calculate_model_matrix(i);
-            program.uniformMatrix4f("model", model);
+            state.program.uniformMatrix4f("model", model);
 
-            if (tessellation_support)
+            if (state.tessellation_support)
             {
 #ifdef USE_GLES32
                 GL_CALL(glDrawElements(GL_PATCHES, 6, GL_UNSIGNED_INT, &indexData));
@@ -612,19 +640,20 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
 
     void render(const wf::scene::render_instruction_t& data, std::vector<wf::auxilliary_buffer_t>& buffers)
     {
+        auto& state = gl.get();
         data.pass->custom_gles_subpass([&]
         {
-            if (program.get_program_id(wf::TEXTURE_TYPE_RGBA) == 0)
+            if (state.program.get_program_id(wf::TEXTURE_TYPE_RGBA) == 0)
             {
-                load_program();
+                load_program(state);
             }
 
             GL_CALL(glClear(GL_DEPTH_BUFFER_BIT));
-            background->render_frame(data.target, animation);
+            state.background->render_frame(data.target, animation);
 
             auto vp = calculate_vp_matrix(data.target);
 
-            program.use(wf::TEXTURE_TYPE_RGBA);
+            state.program.use(wf::TEXTURE_TYPE_RGBA);
             GL_CALL(glEnable(GL_DEPTH_TEST));
             GL_CALL(glDepthFunc(GL_LESS));
 
@@ -642,14 +671,14 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
                 0.0f, 0.0f
             };
 
-            program.attrib_pointer("position", 2, 0, vertexData);
-            program.attrib_pointer("uvPosition", 2, 0, coordData);
-            program.uniformMatrix4f("VP", vp);
-            if (tessellation_support)
+            state.program.attrib_pointer("position", 2, 0, vertexData);
+            state.program.attrib_pointer("uvPosition", 2, 0, coordData);
+            state.program.uniformMatrix4f("VP", vp);
+            if (state.tessellation_support)
             {
-                program.uniform1i("deform", use_deform);
-                program.uniform1i("light", use_light);
-                program.uniform1f("ease",
+                state.program.uniform1i("deform", use_deform);
+                state.program.uniform1i("light", use_light);
+                state.program.uniform1f("ease",
                     animation.cube_animation.ease_deformation);
             }
 
@@ -658,12 +687,12 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
              * that are on the back, and then we render those at the front, so we
              * don't have to use depth testing and we also can support alpha cube. */
             GL_CALL(glEnable(GL_CULL_FACE));
-            render_cube(GL_CCW, buffers);
-            render_cube(GL_CW, buffers);
+            render_cube(state, GL_CCW, buffers);
+            render_cube(state, GL_CW, buffers);
             GL_CALL(glDisable(GL_CULL_FACE));
 
             GL_CALL(glDisable(GL_DEPTH_TEST));
-            program.deactivate();
+            state.program.deactivate();
         });
     }
 
@@ -758,10 +787,7 @@ class wayfire_cube : public wf::per_output_plugin_instance_t, public wf::pointer
             deactivate();
         }
 
-        wf::gles::run_in_context_if_gles([&]
-        {
-            program.free_resources();
-        });
+        gl.release();
     }
 };
 
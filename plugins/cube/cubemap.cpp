@@ -24,6 +24,11 @@ wf_cube_background_cubemap::~wf_cube_background_cubemap()
     });
 }
 
+int64_t wf_cube_background_cubemap::get_memory_usage() const
+{
+    return texture_size;
+}
+
 void wf_cube_background_cubemap::create_program()
 {
     wf::gles::run_in_context([&]
@@ -42,6 +47,23 @@ void wf_cube_background_cubemap::reload_texture()
 
     last_background_image = background_image;
 
+    // The image is decoded in the background, the old texture (if any) is shown until then.
+    // A new token also invalidates requests for previous images which are still in progress.
+    loading    = true;
+    load_token = std::make_shared<bool>(true);
+    image_io::load_from_file_async(last_background_image,
+        [this, token = std::weak_ptr<bool>(load_token)] (image_io::decoded_image_ptr image)
+    {
+        if (!token.expired())
+        {
+            loading = false;
+            upload_texture(image);
+        }
+    });
+}
+
+void wf_cube_background_cubemap::upload_texture(image_io::decoded_image_ptr image)
+{
     wf::gles::run_in_context([&]
     {
         if (tex == (uint32_t)-1)
@@ -52,10 +74,10 @@ void wf_cube_background_cubemap::reload_texture()
         }
 
         GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, tex));
-        if (!image_io::load_from_file(last_background_image, GL_TEXTURE_CUBE_MAP))
+        texture_size = 0;
+        if (!image || !image_io::upload_to_texture(*image, GL_TEXTURE_CUBE_MAP))
         {
-            LOGE("Failed to load cubemap background image from \"%s\".",
-                last_background_image.c_str());
+            LOGE("Failed to load cubemap background image from \"", last_background_image, "\".");
 
             GL_CALL(glDeleteTextures(1, &tex));
             GL_CALL(glDeleteBuffers(1, &vbo_cube_vertices));
@@ -65,6 +87,8 @@ void wf_cube_background_cubemap::reload_texture()
 
         if (tex != (uint32_t)-1)
         {
+            const int64_t face_size = image->width / 4;
+            texture_size = 6 * face_size * face_size * image->channels;
             GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
                 GL_LINEAR));
             GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER,
@@ -88,7 +112,14 @@ void wf_cube_background_cubemap::render_frame(const wf::render_target_t& fb,
 
     if (tex == (uint32_t)-1)
     {
-        GL_CALL(glClearColor(TEX_ERROR_FLAG_COLOR));
+        if (loading)
+        {
+            GL_CALL(glClearColor(0, 0, 0, 1));
+        } else
+        {
+            GL_CALL(glClearColor(TEX_ERROR_FLAG_COLOR));
+        }
+
         GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
         return;
     }
@@ -2,6 +2,8 @@
 #define WF_CUBE_CUBEMAP_HPP
 
 #include "cube-background.hpp"
+#include <wayfire/img.hpp>
+#include <memory>
 
 class wf_cube_background_cubemap : public wf_cube_background_base
 {
@@ -11,13 +13,19 @@ class wf_cube_background_cubemap : public wf_cube_background_base
         wf_cube_animation_attribs& attribs) override;
 
     ~wf_cube_background_cubemap();
+    int64_t get_memory_usage() const override;
 
   private:
     void reload_texture();
+    void upload_texture(image_io::decoded_image_ptr image);
     void create_program();
 
     OpenGL::program_t program;
     GLuint tex = -1;
+    // Size of the six faces of the texture.
+    int64_t texture_size = 0;
+    bool loading = false;
+    std::shared_ptr<bool> load_token;
     GLuint vbo_cube_vertices;
     GLuint ibo_cube_indices;
 
@@ -31,6 +31,12 @@ wf_cube_background_skydome::~wf_cube_background_skydome()
     });
 }
 
+int64_t wf_cube_background_skydome::get_memory_usage() const
+{
+    return texture_size + (vertices.capacity() + coords.capacity()) * sizeof(GLfloat) +
+           indices.capacity() * sizeof(GLuint);
+}
+
 void wf_cube_background_skydome::load_program()
 {
     wf::gles::run_in_context([&]
@@ -47,6 +53,24 @@ void wf_cube_background_skydome::reload_texture()
     }
 
     last_background_image = background_image;
+
+    // The image is decoded in the background, the old texture (if any) is shown until then.
+    // A new token also invalidates requests for previous images which are still in progress.
+    loading    = true;
+    load_token = std::make_shared<bool>(true);
+    image_io::load_from_file_async(last_background_image,
+        [this, token = std::weak_ptr<bool>(load_token)] (image_io::decoded_image_ptr image)
+    {
+        if (!token.expired())
+        {
+            loading = false;
+            wf::gles::run_in_context([&] { upload_texture(image); });
+        }
+    });
+}
+
+void wf_cube_background_skydome::upload_texture(image_io::decoded_image_ptr image)
+{
     if (tex == (uint32_t)-1)
     {
         GL_CALL(glGenTextures(1, &tex));
@@ -54,16 +78,17 @@ void wf_cube_background_skydome::reload_texture()
 
     GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
 
-    if (image_io::load_from_file(last_background_image, GL_TEXTURE_2D))
+    texture_size = 0;
+    if (image && image_io::upload_to_texture(*image, GL_TEXTURE_2D))
     {
+        texture_size = (int64_t)image->width * image->height * image->channels;
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
     } else
     {
-        LOGE("Failed to load skydome image from \"%s\".",
-            last_background_image.c_str());
+        LOGE("Failed to load skydome image from \"", last_background_image, "\".");
         GL_CALL(glDeleteTextures(1, &tex));
         tex = -1;
     }
@@ -134,7 +159,14 @@ void wf_cube_background_skydome::render_frame(const wf::render_target_t& fb,
 
     if (tex == (uint32_t)-1)
     {
-        GL_CALL(glClearColor(TEX_ERROR_FLAG_COLOR));
+        if (loading)
+        {
+            GL_CALL(glClearColor(0, 0, 0, 1));
+        } else
+        {
+            GL_CALL(glClearColor(TEX_ERROR_FLAG_COLOR));
+        }
+
         GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
 
         return;
@@ -3,6 +3,8 @@
 
 #include "cube-background.hpp"
 #include "wayfire/output.hpp"
+#include <wayfire/img.hpp>
+#include <memory>
 #include <vector>
 
 class wf_cube_background_skydome : public wf_cube_background_base
@@ -13,6 +15,7 @@ class wf_cube_background_skydome : public wf_cube_background_base
         wf_cube_animation_attribs& attribs) override;
 
     virtual ~wf_cube_background_skydome();
+    int64_t get_memory_usage() const override;
 
   private:
     wf::output_t *output;
@@ -20,9 +23,13 @@ class wf_cube_background_skydome : public wf_cube_background_base
     void load_program();
     void fill_vertices();
     void reload_texture();
+    void upload_texture(image_io::decoded_image_ptr image);
 
     OpenGL::program_t program;
     GLuint tex = -1;
+    int64_t texture_size = 0;
+    bool loading = false;
+    std::shared_ptr<bool> load_token;
 
     std::vector<GLfloat> vertices;
     std::vector<GLfloat> coords;
@@ -5,7 +5,9 @@
 #include "wayfire/scene.hpp"
 #include "wayfire/signal-provider.hpp"
 #include "wayfire/toplevel.hpp"
+#include <cmath>
 #include <memory>
+#include <optional>
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -21,9 +23,11 @@
 #include "deco-subsurface.hpp"
 #include "deco-layout.hpp"
 #include "deco-theme.hpp"
+#include "deco-title-cache.hpp"
 #include <wayfire/window-manager.hpp>
 
 #include <wayfire/plugins/common/cairo-util.hpp>
+#include <wayfire/plugins/common/shared-core-data.hpp>
 
 #include <cairo.h>
 
@@ -42,30 +46,69 @@ class simple_decoration_node_t : public wf::scene::node_t, public wf::pointer_in
 
     void update_title(int width, int height, double scale)
     {
-        if (auto view = _view.lock())
+        auto view = _view.lock();
+        if (!view)
         {
-            wf::dimensions_t target_size = {
-                static_cast<int32_t>(width * scale),
-                static_cast<int32_t>(height * scale)
-            };
+            return;
+        }
 
-            if ((title_texture.tex.get_size() != target_size) ||
-                (title_texture.current_text != view->get_title()))
+        wf::decor::title_key_t key{
+            .text   = view->get_title(),
+            .font   = theme.get_font(),
+            .color  = theme.get_font_color(),
+            .width  = wf::decor::title_texture_cache_t::bucket_width(std::ceil(width * scale)),
+            .height = static_cast<int32_t>(height * scale),
+        };
+
+        if ((title_texture.key == key) || (title_texture.pending == key))
+        {
+            return;
+        }
+
+        // Keep showing the old title until the new one has been rendered in the background.
+        title_texture.pending = key;
+        auto self = std::weak_ptr<wf::scene::node_t>(shared_from_this());
+        auto tex  = title_cache->request(key, [self, key] (auto tex)
+        {
+            if (auto node = self.lock())
             {
-                auto surface = theme.render_text(view->get_title(), target_size.width, target_size.height);
-                title_texture.tex = wf::owned_texture_t{surface};
-                cairo_surface_destroy(surface);
-                title_texture.current_text = view->get_title();
+                std::static_pointer_cast<simple_decoration_node_t>(node)->set_title_texture(key, tex, true);
             }
+        });
+
+        if (tex)
+        {
+            set_title_texture(key, tex, false);
+        }
+    }
+
+    void set_title_texture(const wf::decor::title_key_t& key,
+        wf::decor::title_texture_cache_t::texture_ptr tex, bool need_damage)
+    {
+        if (title_texture.pending != key)
+        {
+            // A newer title was requested in the meantime
+            return;
+        }
+
+        title_texture.tex = tex;
+        title_texture.key = key;
+        title_texture.pending.reset();
+        if (need_damage)
+        {
+            wf::scene::damage_node(shared_from_this(), get_bounding_box());
         }
     }
 
     struct
     {
-        wf::owned_texture_t tex;
-        std::string current_text = "";
+        wf::decor::title_texture_cache_t::texture_ptr tex;
+        std::optional<wf::decor::title_key_t> key;
+        std::optional<wf::decor::title_key_t> pending;
     } title_texture;
 
+    wf::shared_data::ref_ptr_t<wf::decor::title_texture_cache_t> title_cache;
+
   public:
     wf::decor::decoration_theme_t theme;
     wf::decor::decoration_layout_t layout;
@@ -124,10 +167,20 @@ class simple_decoration_node_t : public wf::scene::node_t, public wf::pointer_in
             {
                 wf::geometry_t title_geometry = item->get_geometry() + origin;
                 update_title(title_geometry.width, title_geometry.height, data.target.scale);
-                if (title_texture.tex.get_texture().texture != NULL)
+                if (title_texture.tex && (title_texture.tex->get_texture().texture != NULL))
                 {
-                    data.pass->add_texture(title_texture.tex.get_texture(), data.target,
-                        title_geometry, data.damage);
+                    // The texture is wider than the title area (bucketed width), and might also be
+                    // an older texture for a different scale, so scale it to the title height and
+                    // clip it to the title area.
+                    auto tex_size = title_texture.tex->get_size();
+                    double ratio  = (double)title_geometry.height / tex_size.height;
+                    wf::geometry_t tex_geometry = {
+                        title_geometry.x, title_geometry.y,
+                        (int)std::ceil(tex_size.width * ratio), title_geometry.height,
+                    };
+
+                    data.pass->add_texture(title_texture.tex->get_texture(), data.target,
+                        tex_geometry, data.damage & title_geometry);
                 }
             } else // button
             {
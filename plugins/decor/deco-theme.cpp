@@ -50,6 +50,12 @@ void decoration_theme_t::render_background(const wf::scene::render_instruction_t
  */
 cairo_surface_t*decoration_theme_t::render_text(std::string text,
     int width, int height) const
+{
+    return render_text(text, font, font_color, width, height);
+}
+
+cairo_surface_t*decoration_theme_t::render_text(const std::string& text,
+    const std::string& font, wf::color_t color, int width, int height)
 {
     const auto format = CAIRO_FORMAT_ARGB32;
     auto surface = cairo_image_surface_create(format, width, height);
@@ -59,7 +65,6 @@ cairo_surface_t*decoration_theme_t::render_text(std::string text,
         return surface;
     }
 
-    wf::color_t color = font_color;
     auto cr = cairo_create(surface);
 
     const float font_scale = 0.8;
@@ -69,7 +74,7 @@ cairo_surface_t*decoration_theme_t::render_text(std::string text,
     PangoLayout *layout;
 
     // render text
-    font_desc = pango_font_description_from_string(((std::string)font).c_str());
+    font_desc = pango_font_description_from_string(font.c_str());
     pango_font_description_set_absolute_size(font_desc, font_size * PANGO_SCALE);
 
     layout = pango_cairo_create_layout(cr);
@@ -80,10 +85,21 @@ cairo_surface_t*decoration_theme_t::render_text(std::string text,
     pango_font_description_free(font_desc);
     g_object_unref(layout);
     cairo_destroy(cr);
+    cairo_surface_flush(surface);
 
     return surface;
 }
 
+std::string decoration_theme_t::get_font() const
+{
+    return font;
+}
+
+wf::color_t decoration_theme_t::get_font_color() const
+{
+    return font_color;
+}
+
 cairo_surface_t*decoration_theme_t::get_button_surface(button_type_t button,
     const button_state_t& state) const
 {
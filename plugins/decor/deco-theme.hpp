@@ -41,6 +41,18 @@ class decoration_theme_t
      */
     cairo_surface_t *render_text(std::string text, int width, int height) const;
 
+    /**
+     * Same as render_text(), but with explicit font and color instead of the theme options.
+     * Does not access any compositor state, so it is safe to call from worker threads.
+     */
+    static cairo_surface_t *render_text(const std::string& text, const std::string& font,
+        wf::color_t color, int width, int height);
+
+    /** @return The font used for the title */
+    std::string get_font() const;
+    /** @return The color used for the title */
+    wf::color_t get_font_color() const;
+
     struct button_state_t
     {
         /** Button width */
@@ -0,0 +1,109 @@
+#include "deco-title-cache.hpp"
+#include "deco-theme.hpp"
+#include <wayfire/core.hpp>
+#include <wayfire/worker-pool.hpp>
+
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <vector>
+
+namespace wf
+{
+namespace decor
+{
+/* Round title widths up to a multiple of this, in physical pixels. */
+static constexpr int TITLE_WIDTH_BUCKET = 128;
+
+bool title_key_t::operator <(const title_key_t& other) const
+{
+    return std::tie(text, font, color.r, color.g, color.b, color.a, width, height) <
+           std::tie(other.text, other.font, other.color.r, other.color.g, other.color.b, other.color.a,
+        other.width, other.height);
+}
+
+bool title_key_t::operator ==(const title_key_t& other) const
+{
+    return !(*this < other) && !(other < *this);
+}
+
+std::string title_key_t::to_string() const
+{
+    std::ostringstream out;
+    out << "decor-title;" << font << ';' << color.r << ',' << color.g << ',' << color.b << ',' <<
+        color.a << ';' << width << 'x' << height << ';' << text;
+    return out.str();
+}
+
+struct title_texture_cache_t::state_t
+{
+    /* Titles currently being rendered, and who is waiting for them */
+    std::map<title_key_t, std::vector<ready_callback_t>> pending;
+    wf::shared_data::ref_ptr_t<wf::text_texture_cache_t> text_cache;
+};
+
+title_texture_cache_t::title_texture_cache_t()
+{
+    state = std::make_shared<state_t>();
+}
+
+title_texture_cache_t::~title_texture_cache_t() = default;
+
+int title_texture_cache_t::bucket_width(int width)
+{
+    return (width + TITLE_WIDTH_BUCKET - 1) / TITLE_WIDTH_BUCKET * TITLE_WIDTH_BUCKET;
+}
+
+title_texture_cache_t::texture_ptr title_texture_cache_t::request(const title_key_t& key,
+    ready_callback_t on_ready)
+{
+    auto it = state->pending.find(key);
+    if (it != state->pending.end())
+    {
+        it->second.push_back(std::move(on_ready));
+        return nullptr;
+    }
+
+    const auto cache_key = key.to_string();
+    if (auto cached = state->text_cache->find(cache_key))
+    {
+        return cached->texture;
+    }
+
+    state->pending[key] = {};
+    auto surface = std::make_shared<std::shared_ptr<cairo_surface_t>>();
+    auto result  = std::make_shared<texture_ptr>();
+    wf::get_core().workers->submit([key, surface] ()
+    {
+        *surface = std::shared_ptr<cairo_surface_t>(
+            decoration_theme_t::render_text(key.text, key.font, key.color, key.width, key.height),
+            cairo_surface_destroy);
+    }, [key, cache_key, surface, result, weak_state = std::weak_ptr<state_t>(state)] ()
+    {
+        auto tex = std::make_shared<wf::owned_texture_t>(surface->get());
+        *result = tex;
+
+        if (auto state = weak_state.lock())
+        {
+            auto size = tex->get_size();
+            state->text_cache->insert(cache_key, {tex, size, size});
+            auto callbacks = std::move(state->pending[key]);
+            state->pending.erase(key);
+            for (auto& cb : callbacks)
+            {
+                cb(tex);
+            }
+        }
+    });
+
+    // If the worker pool ran the job synchronously, the texture is already available.
+    if (*result)
+    {
+        return *result;
+    }
+
+    state->pending[key].push_back(std::move(on_ready));
+    return nullptr;
+}
+}
+}
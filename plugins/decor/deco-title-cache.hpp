@@ -0,0 +1,67 @@
+#pragma once
+
+#include <wayfire/plugins/common/cairo-util.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace wf
+{
+namespace decor
+{
+/**
+ * Everything which determines how a title is rasterized.
+ */
+struct title_key_t
+{
+    std::string text;
+    std::string font;
+    wf::color_t color;
+    /** Size of the rasterized title, in physical pixels. The width should be bucketed. */
+    int width;
+    int height;
+
+    bool operator <(const title_key_t& other) const;
+    bool operator ==(const title_key_t& other) const;
+
+    /** @return The key used for the shared wf::text_texture_cache_t. */
+    std::string to_string() const;
+};
+
+/**
+ * Renders window titles in the background, on top of the process-wide wf::text_texture_cache_t.
+ *
+ * Titles are rendered with Pango/Cairo on a worker thread and uploaded to a texture on the main thread
+ * once done. Because the widths are bucketed, interactive resizing only occasionally needs a new
+ * texture, and views with the same title (e.g. several terminals) share the same texture.
+ */
+class title_texture_cache_t
+{
+  public:
+    using texture_ptr = std::shared_ptr<wf::owned_texture_t>;
+    using ready_callback_t = std::function<void (texture_ptr)>;
+
+    title_texture_cache_t();
+    ~title_texture_cache_t();
+
+    /**
+     * Get the texture for the given title.
+     *
+     * @return The texture if it is available immediately. Otherwise, rendering is scheduled in the
+     *   background (unless it is already in progress), nullptr is returned and @on_ready is called once the
+     *   texture becomes available.
+     */
+    texture_ptr request(const title_key_t& key, ready_callback_t on_ready);
+
+    /**
+     * Round the width (in physical pixels) of a title area up, so that small changes in the width result
+     * in the same texture.
+     */
+    static int bucket_width(int width);
+
+  private:
+    struct state_t;
+    std::shared_ptr<state_t> state;
+};
+}
+}
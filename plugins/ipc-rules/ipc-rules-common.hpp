@@ -4,6 +4,7 @@
 #include "wayfire/plugins/ipc/ipc-method-repository.hpp"
 #include <wayfire/output.hpp>
 #include <wayfire/workarea.hpp>
+#include <wayfire/render-manager.hpp>
 #include <wayfire/workspace-set.hpp>
 #include "config.h"
 #include "wayfire/plugins/common/util.hpp"
@@ -13,6 +14,24 @@
 
 namespace wf::ipc_rules
 {
+static inline std::string content_type_to_string(wf::output_content_type_t type)
+{
+    switch (type)
+    {
+      case wf::output_content_type_t::PHOTO:
+        return "photo";
+
+      case wf::output_content_type_t::VIDEO:
+        return "video";
+
+      case wf::output_content_type_t::GAME:
+        return "game";
+
+      default:
+        return "none";
+    }
+}
+
 static inline wf::json_t output_to_json(wf::output_t *o)
 {
     if (!o)
@@ -30,6 +49,7 @@ static inline wf::json_t output_to_json(wf::output_t *o)
     response["workspace"]["y"] = o->wset()->get_current_workspace().y;
     response["workspace"]["grid_width"]  = o->wset()->get_workspace_grid_size().width;
     response["workspace"]["grid_height"] = o->wset()->get_workspace_grid_size().height;
+    response["content-type"] = content_type_to_string(o->render->get_content_type());
     return response;
 }
 
@@ -4,12 +4,18 @@
 #include "wayfire/plugins/ipc/ipc-method-repository.hpp"
 #include "wayfire/debug.hpp"
 #include "wayfire/signal-definitions.hpp"
+#include <algorithm>
 #include <set>
 #include <wayfire/plugin.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/output-layout.hpp>
 #include <wayfire/config/compound-option.hpp>
 #include <wayfire/config/config-manager.hpp>
+#include <wayfire/plugins/common/cairo-util.hpp>
+#include <wayfire/plugins/common/deferred-state.hpp>
+#include <wayfire/unstable/output-capture.hpp>
+#include <wayfire/unstable/startup-timeline.hpp>
+#include <wayfire/trace.hpp>
 
 extern "C" {
 #include <wlr/backend/headless.h>
@@ -23,6 +29,10 @@ class ipc_rules_utility_methods_t
   private:
     wlr_backend *headless_backend = NULL;
     std::set<uint64_t> our_outputs;
+    // Keeps the budget set over IPC while no plugin renders text.
+    wf::shared_data::ref_ptr_t<wf::text_texture_cache_t> text_texture_cache;
+    // Keeps the statistics of plugins which have already been unloaded.
+    wf::shared_data::ref_ptr_t<wf::deferred_state_stats_t> deferred_state_stats;
 
   public:
     void init_utility_methods(ipc::method_repository_t *method_repository)
@@ -35,6 +45,14 @@ class ipc_rules_utility_methods_t
         method_repository->register_method("wayfire/set-config-options", set_config_options);
         method_repository->register_method("wayfire/get-keyboard-state", get_kb_state);
         method_repository->register_method("wayfire/set-keyboard-state", set_kb_state);
+        method_repository->register_method("wayfire/text-cache", text_cache);
+        method_repository->register_method("wayfire/presentation-stats", get_presentation_stats);
+        method_repository->register_method("wayfire/scanout-stats", get_scanout_stats);
+        method_repository->register_method("wayfire/capture-stats", get_capture_stats);
+        method_repository->register_method("wayfire/startup-timeline", get_startup_timeline);
+        method_repository->register_method("wayfire/deferred-state-stats", get_deferred_state_stats);
+        method_repository->register_method("wayfire/trace-start", trace_start);
+        method_repository->register_method("wayfire/trace-stop", trace_stop);
     }
 
     void fini_utility_methods(ipc::method_repository_t *method_repository)
@@ -47,6 +65,14 @@ class ipc_rules_utility_methods_t
         method_repository->unregister_method("wayfire/set-config-option");
         method_repository->unregister_method("wayfire/get-keyboard-state");
         method_repository->unregister_method("wayfire/set-keyboard-state");
+        method_repository->unregister_method("wayfire/text-cache");
+        method_repository->unregister_method("wayfire/presentation-stats");
+        method_repository->unregister_method("wayfire/scanout-stats");
+        method_repository->unregister_method("wayfire/capture-stats");
+        method_repository->unregister_method("wayfire/startup-timeline");
+        method_repository->unregister_method("wayfire/deferred-state-stats");
+        method_repository->unregister_method("wayfire/trace-start");
+        method_repository->unregister_method("wayfire/trace-stop");
     }
 
     wf::ipc::method_callback get_wayfire_configuration_info = [=] (wf::json_t)
@@ -372,5 +398,199 @@ class ipc_rules_utility_methods_t
             keyboard->modifiers.latched, keyboard->modifiers.locked, index);
         return wf::ipc::json_ok();
     };
+
+    wf::ipc::method_callback text_cache = [=] (const wf::json_t& data) -> json_t
+    {
+        auto& cache = *text_texture_cache.get();
+        if (auto budget = wf::ipc::json_get_optional_uint64(data, "budget"))
+        {
+            cache.set_budget(budget.value());
+        }
+
+        if (wf::ipc::json_get_optional_bool(data, "clear").value_or(false))
+        {
+            cache.clear();
+        }
+
+        auto stats    = cache.get_stats();
+        auto response = wf::ipc::json_ok();
+        response["hits"]      = stats.hits;
+        response["misses"]    = stats.misses;
+        response["evictions"] = stats.evictions;
+        response["entries"]   = (uint64_t)stats.entries;
+        response["bytes"]     = (uint64_t)stats.bytes;
+        response["budget"]    = (uint64_t)stats.budget;
+        const auto lookups = stats.hits + stats.misses;
+        response["hit-rate"] = lookups ? (double)stats.hits / lookups : 0.0;
+        return response;
+    };
+
+    wf::ipc::method_callback get_presentation_stats = [=] (wf::json_t data)
+    {
+        auto view = wf::ipc::json_find_view_or_throw(data);
+        wf::json_t surfaces = wf::json_t::array();
+
+        std::function<void(wf::scene::node_ptr)> collect = [&] (wf::scene::node_ptr node)
+        {
+            if (auto surface_node = dynamic_cast<wf::scene::wlr_surface_node_t*>(node.get()))
+            {
+                const auto& stats = surface_node->get_presentation_stats();
+                wf::json_t entry;
+                entry["main"]      = (surface_node->get_surface() == view->get_wlr_surface());
+                entry["commits"]   = stats.commits;
+                entry["presented"] = stats.presented;
+                entry["dropped"]   = stats.dropped;
+                entry["avg-latency-ms"] = stats.presented ?
+                    stats.total_latency_us / 1000.0 / stats.presented : 0.0;
+                if (auto cadence = surface_node->get_commit_cadence())
+                {
+                    entry["cadence-ms"] = cadence->period_us / 1000.0;
+                } else
+                {
+                    entry["cadence-ms"] = wf::json_t::null();
+                }
+
+                surfaces.append(entry);
+            }
+
+            for (auto& ch : node->get_children())
+            {
+                collect(ch);
+            }
+        };
+
+        collect(view->get_surface_root_node());
+        auto response = wf::ipc::json_ok();
+        response["surfaces"] = surfaces;
+        return response;
+    };
+
+    wf::ipc::method_callback get_scanout_stats = [=] (wf::json_t data)
+    {
+        auto id = wf::ipc::json_get_uint64(data, "id");
+        auto wo = wf::ipc::find_output_by_id(id);
+        if (!wo)
+        {
+            return wf::ipc::json_error("output not found");
+        }
+
+        static constexpr size_t MAX_REPORTED_BLOCKERS = 5;
+        const auto& stats = wo->render->get_direct_scanout_stats();
+        std::vector<std::pair<uint64_t, wf::scene::scanout_blocker_t>> blockers;
+        for (size_t i = 0; i < stats.blockers.size(); i++)
+        {
+            if (stats.blockers[i] > 0)
+            {
+                blockers.emplace_back(stats.blockers[i], (wf::scene::scanout_blocker_t)i);
+            }
+        }
+
+        std::sort(blockers.begin(), blockers.end(),
+            [] (const auto& a, const auto& b) { return a.first > b.first; });
+        wf::json_t top_blockers = wf::json_t::array();
+        for (size_t i = 0; i < std::min(blockers.size(), MAX_REPORTED_BLOCKERS); i++)
+        {
+            wf::json_t entry;
+            entry["reason"] = std::string(wf::scene::scanout_blocker_to_string(blockers[i].second));
+            entry["count"]  = blockers[i].first;
+            top_blockers.append(entry);
+        }
+
+        auto last_node = stats.last_blocker_node.lock();
+        auto response  = wf::ipc::json_ok();
+        response["attempts"]  = stats.attempts;
+        response["successes"] = stats.successes;
+        response["last-blocker"] = std::string(wf::scene::scanout_blocker_to_string(stats.last_blocker));
+        response["last-blocker-node"] = last_node ? last_node->stringify() : std::string{};
+        response["top-blockers"] = top_blockers;
+        return response;
+    };
+
+    wf::ipc::method_callback get_capture_stats = [=] (wf::json_t data)
+    {
+        auto id = wf::ipc::json_get_uint64(data, "id");
+        auto wo = wf::ipc::find_output_by_id(id);
+        if (!wo)
+        {
+            return wf::ipc::json_error("output not found");
+        }
+
+        auto response = wf::ipc::json_ok();
+        auto stats    = wo->get_data<wf::output_capture_stats_t>();
+        response["frames"] = stats ? stats->frames : 0;
+        response["full-copies"]  = stats ? stats->full_copies : 0;
+        response["bytes-copied"] = stats ? stats->bytes_copied : 0;
+        return response;
+    };
+
+    wf::ipc::method_callback get_startup_timeline = [=] (wf::json_t)
+    {
+        auto timeline = wf::get_core().get_data_safe<wf::startup_timeline_t>();
+        wf::json_t phases = wf::json_t::array();
+        for (auto& phase : timeline->phases)
+        {
+            wf::json_t entry;
+            entry["name"]  = phase.name;
+            entry["start-us"]    = phase.start_us;
+            entry["duration-us"] = phase.duration_us;
+            phases.append(entry);
+        }
+
+        auto response = wf::ipc::json_ok();
+        response["finished"] = timeline->finished;
+        response["phases"]   = phases;
+        return response;
+    };
+
+    wf::ipc::method_callback get_deferred_state_stats = [=] (wf::json_t)
+    {
+        wf::json_t plugins = wf::json_t::array();
+        int64_t total_saved = 0;
+        for (auto& [name, entry] : deferred_state_stats->plugins)
+        {
+            wf::json_t plugin;
+            plugin["name"] = name;
+            plugin["activations"] = entry.activations;
+            plugin["releases"]    = entry.releases;
+            plugin["resident-instances"] = (uint64_t)entry.resident.size();
+            plugin["resident-bytes"]     = entry.get_resident_bytes();
+            plugin["saved-bytes"] = entry.released_bytes;
+            plugins.append(plugin);
+            total_saved += entry.released_bytes;
+        }
+
+        auto response = wf::ipc::json_ok();
+        response["plugins"]     = plugins;
+        response["saved-bytes"] = total_saved;
+        return response;
+    };
+
+    wf::ipc::method_callback trace_start = [=] (wf::json_t data)
+    {
+#ifdef WF_ENABLE_TRACING
+        auto path = wf::ipc::json_get_string(data, "path");
+        if (!wf::trace::start(path))
+        {
+            return wf::ipc::json_error("a trace is already being recorded");
+        }
+
+        return wf::ipc::json_ok();
+#else
+        return wf::ipc::json_error("Wayfire was built without tracing support");
+#endif
+    };
+
+    wf::ipc::method_callback trace_stop = [=] (wf::json_t)
+    {
+        int64_t events = wf::trace::stop();
+        if (events < 0)
+        {
+            return wf::ipc::json_error("no trace is being recorded");
+        }
+
+        auto response = wf::ipc::json_ok();
+        response["events"] = events;
+        return response;
+    };
 };
 }
@@ -4,6 +4,7 @@
 #include <wayfire/util/log.hpp>
 #include <wayfire/core.hpp>
 #include <wayfire/plugin.hpp>
+#include <wayfire/trace.hpp>
 
 #include <fcntl.h>
 #include <sys/socket.h>
@@ -134,6 +135,7 @@ void wf::ipc::server_t::client_disappeared(client_t *client)
 void wf::ipc::server_t::handle_incoming_message(
     client_t *client, wf::json_t message)
 {
+    WF_TRACE_SCOPE("ipc-message");
     client->send_json(method_repository->call_method(message["method"], message["data"], client));
 }
 
@@ -10,6 +10,10 @@
 #include <wayfire/output-layout.hpp>
 #include <wayfire/txn/transaction-manager.hpp>
 #include "src/view/view-impl.hpp"
+#include <wayfire/render.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <algorithm>
+#include <set>
 #include <variant>
 #include <cstring>
 
@@ -305,6 +309,11 @@ class stipc_plugin_t : public wf::plugin_interface_t
         method_repository->register_method("stipc/tablet/tool_tip", do_tool_tip);
         method_repository->register_method("stipc/tablet/pad_button", do_pad_button);
         method_repository->register_method("stipc/delay_next_tx", delay_next_tx);
+        method_repository->register_method("stipc/record/start", record_start);
+        method_repository->register_method("stipc/record/stop", record_stop);
+        method_repository->register_method("stipc/record/events", record_events);
+        method_repository->register_method("stipc/replay", replay);
+        method_repository->register_method("stipc/replay/stats", replay_stats);
     }
 
     bool is_unloadable() override
@@ -312,7 +321,12 @@ class stipc_plugin_t : public wf::plugin_interface_t
         return false;
     }
 
-    ipc::method_callback layout_views = [] (wf::json_t data) -> wf::json_t
+    /**
+     * Set the geometry of the given views. Each view is identified either by its "id", or by its "app-id", in
+     * which case the first toplevel view with this app-id which is not laid out by the same call is used.
+     * The latter is used for recorded sessions, where view ids are not stable across runs.
+     */
+    ipc::method_callback layout_views = [=] (wf::json_t data) -> wf::json_t
     {
         auto views = wf::get_core().get_all_views();
         if (!data.has_member("views") || !data["views"].is_array())
@@ -320,34 +334,58 @@ class stipc_plugin_t : public wf::plugin_interface_t
             return wf::ipc::json_error("Views not specified");
         }
 
+        std::set<uint64_t> used_ids;
+        wf::json_t recorded_views = wf::json_t::array();
         for (size_t i = 0; i < data["views"].size(); i++)
         {
             const auto& v = data["views"][i];
-            auto id   = wf::ipc::json_get_uint64(v, "id");
+            auto app_id = wf::ipc::json_get_optional_string(v, "app-id");
             int x     = wf::ipc::json_get_int64(v, "x");
             int y     = wf::ipc::json_get_int64(v, "y");
             int width = wf::ipc::json_get_int64(v, "width");
             int height  = wf::ipc::json_get_int64(v, "height");
             auto output = wf::ipc::json_get_optional_string(v, "output");
 
-            auto it = std::find_if(views.begin(), views.end(), [&] (auto& view)
+            wayfire_view view;
+            if (app_id.has_value())
             {
-                return view->get_id() == uint64_t(v["id"]);
-            });
+                auto it = std::find_if(views.begin(), views.end(), [&] (auto& view)
+                {
+                    return toplevel_cast(view) && (view->get_app_id() == app_id.value()) &&
+                           !used_ids.count(view->get_id());
+                });
+
+                if (it == views.end())
+                {
+                    return wf::ipc::json_error("Could not find view with app-id " + app_id.value());
+                }
 
-            if (it == views.end())
+                view = *it;
+            } else
             {
-                return wf::ipc::json_error("Could not find view with id " +
-                    std::to_string(id));
+                auto id = wf::ipc::json_get_uint64(v, "id");
+                auto it = std::find_if(views.begin(), views.end(), [&] (auto& view)
+                {
+                    return view->get_id() == id;
+                });
+
+                if (it == views.end())
+                {
+                    return wf::ipc::json_error("Could not find view with id " +
+                        std::to_string(id));
+                }
+
+                view = *it;
             }
 
-            auto toplevel = toplevel_cast(*it);
+            auto toplevel = toplevel_cast(view);
             if (!toplevel)
             {
                 return wf::ipc::json_error("View is not toplevel view id " +
-                    std::to_string(id));
+                    std::to_string(view->get_id()));
             }
 
+            used_ids.insert(view->get_id());
             if (output.has_value())
             {
                 auto wo = wf::get_core().output_layout->find_output(output.value());
@@ -361,6 +399,14 @@ class stipc_plugin_t : public wf::plugin_interface_t
 
             wf::geometry_t g{x, y, width, height};
             toplevel->set_geometry(g);
+            recorded_views.append(describe_view_layout(toplevel, g));
+        }
+
+        if (recording)
+        {
+            wf::json_t recorded;
+            recorded["views"] = recorded_views;
+            record_event("stipc/layout_views", recorded);
         }
 
         return wf::ipc::json_ok();
@@ -626,6 +672,437 @@ class stipc_plugin_t : public wf::plugin_interface_t
         return wf::ipc::json_ok();
     };
 
+    // ---------------------------------------- Record and replay -----------------------------------------
+
+    /*
+     * A session is recorded as a list of stipc calls, each of the form {"time": <ms since start>, "method":
+     * "stipc/...", "data": {...}}. It starts with the layout of all toplevel views at the time the recording
+     * was started, followed by the input events of all real input devices, and the layouts set via
+     * stipc/layout_views. Views are identified by their app-id, so a recorded session can be replayed after
+     * starting the same clients, typically on a headless instance (WLR_BACKENDS=headless
+     * WLR_RENDERER=pixman) to get reproducible frame-time and input latency measurements.
+     *
+     * IPC messages are limited to 1 MiB, so long sessions are transferred in chunks: the recorded events are
+     * fetched with stipc/record/events, and a replay is loaded with several stipc/replay calls.
+     */
+    bool recording = false;
+    int64_t recording_start = 0;
+    wf::json_t recorded_events = wf::json_t::array();
+
+    static wf::json_t describe_view_layout(wayfire_toplevel_view view, wf::geometry_t g)
+    {
+        wf::json_t entry;
+        entry["app-id"] = view->get_app_id();
+        entry["x"]      = g.x;
+        entry["y"]      = g.y;
+        entry["width"]  = g.width;
+        entry["height"] = g.height;
+        return entry;
+    }
+
+    void record_event(std::string method, const wf::json_t& data)
+    {
+        wf::json_t entry;
+        entry["time"]   = wf::get_current_time() - recording_start;
+        entry["method"] = method;
+        entry["data"]   = data;
+        recorded_events.append(entry);
+    }
+
+    /** Events from our own devices are replayed events (or test input), so they are not recorded again. */
+    static bool is_stipc_device(wlr_input_device *device)
+    {
+        return device && device->name && !std::strncmp(device->name, "stipc", 5);
+    }
+
+    void record_cursor(wlr_input_device *device)
+    {
+        if (is_stipc_device(device))
+        {
+            return;
+        }
+
+        auto cursor = wf::get_core().get_cursor_position();
+        wf::json_t data;
+        data["x"] = cursor.x;
+        data["y"] = cursor.y;
+        record_event("stipc/move_cursor", data);
+    }
+
+    void record_touch(wlr_input_device *device, int finger)
+    {
+        if (is_stipc_device(device))
+        {
+            return;
+        }
+
+        auto position = wf::get_core().get_touch_position(finger);
+        wf::json_t data;
+        data["finger"] = finger;
+        data["x"] = position.x;
+        data["y"] = position.y;
+        record_event("stipc/touch", data);
+    }
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_pointer_motion_event>> on_record_motion =
+        [=] (wf::post_input_event_signal<wlr_pointer_motion_event> *ev)
+    {
+        record_cursor(ev->device);
+    };
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_pointer_motion_absolute_event>>
+    on_record_motion_absolute = [=] (wf::post_input_event_signal<wlr_pointer_motion_absolute_event> *ev)
+    {
+        record_cursor(ev->device);
+    };
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_pointer_button_event>> on_record_button =
+        [=] (wf::post_input_event_signal<wlr_pointer_button_event> *ev)
+    {
+        const char *name = libevdev_event_code_get_name(EV_KEY, ev->event->button);
+        if (is_stipc_device(ev->device) || !name)
+        {
+            return;
+        }
+
+        wf::json_t data;
+        data["combo"] = name;
+        data["mode"]  = (ev->event->state == WL_POINTER_BUTTON_STATE_PRESSED) ? "press" : "release";
+        record_event("stipc/feed_button", data);
+    };
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_keyboard_key_event>> on_record_key =
+        [=] (wf::post_input_event_signal<wlr_keyboard_key_event> *ev)
+    {
+        const char *name = libevdev_event_code_get_name(EV_KEY, ev->event->keycode);
+        if (is_stipc_device(ev->device) || !name)
+        {
+            return;
+        }
+
+        wf::json_t data;
+        data["key"]   = name;
+        data["state"] = (ev->event->state == WL_KEYBOARD_KEY_STATE_PRESSED);
+        record_event("stipc/feed_key", data);
+    };
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_touch_down_event>> on_record_touch_down =
+        [=] (wf::post_input_event_signal<wlr_touch_down_event> *ev)
+    {
+        record_touch(ev->device, ev->event->touch_id);
+    };
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_touch_motion_event>> on_record_touch_motion =
+        [=] (wf::post_input_event_signal<wlr_touch_motion_event> *ev)
+    {
+        record_touch(ev->device, ev->event->touch_id);
+    };
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_touch_up_event>> on_record_touch_up =
+        [=] (wf::post_input_event_signal<wlr_touch_up_event> *ev)
+    {
+        if (is_stipc_device(ev->device))
+        {
+            return;
+        }
+
+        wf::json_t data;
+        data["finger"] = ev->event->touch_id;
+        record_event("stipc/touch_release", data);
+    };
+
+    ipc::method_callback record_start = [=] (wf::json_t)
+    {
+        if (recording)
+        {
+            return wf::ipc::json_error("Already recording");
+        }
+
+        recording = true;
+        recording_start = wf::get_current_time();
+        recorded_events = wf::json_t::array();
+
+        wf::json_t layout;
+        layout["views"] = wf::json_t::array();
+        for (auto& view : wf::get_core().get_all_views())
+        {
+            auto toplevel = toplevel_cast(view);
+            if (toplevel && toplevel->is_mapped())
+            {
+                layout["views"].append(describe_view_layout(toplevel, toplevel->get_pending_geometry()));
+            }
+        }
+
+        record_event("stipc/layout_views", layout);
+
+        auto& core = wf::get_core();
+        core.connect(&on_record_motion);
+        core.connect(&on_record_motion_absolute);
+        core.connect(&on_record_button);
+        core.connect(&on_record_key);
+        core.connect(&on_record_touch_down);
+        core.connect(&on_record_touch_motion);
+        core.connect(&on_record_touch_up);
+        return wf::ipc::json_ok();
+    };
+
+    /**
+     * Stop recording and return the number of recorded events. They are kept until the next recording
+     * starts, and can be fetched with stipc/record/events.
+     */
+    ipc::method_callback record_stop = [=] (wf::json_t)
+    {
+        if (!recording)
+        {
+            return wf::ipc::json_error("Not recording");
+        }
+
+        recording = false;
+        on_record_motion.disconnect();
+        on_record_motion_absolute.disconnect();
+        on_record_button.disconnect();
+        on_record_key.disconnect();
+        on_record_touch_down.disconnect();
+        on_record_touch_motion.disconnect();
+        on_record_touch_up.disconnect();
+
+        auto response = wf::ipc::json_ok();
+        response["count"] = (uint64_t)recorded_events.size();
+        return response;
+    };
+
+    // The maximal number of events per message, so that each chunk fits in an IPC message.
+    static constexpr size_t MAX_EVENTS_PER_MESSAGE = 4096;
+
+    /**
+     * Get the events recorded so far, starting at "offset", at most "count" (and at most
+     * MAX_EVENTS_PER_MESSAGE) of them. The response also contains the total number of recorded events.
+     */
+    ipc::method_callback record_events = [=] (wf::json_t data)
+    {
+        const uint64_t total  = recorded_events.size();
+        const uint64_t offset = std::min(total,
+            wf::ipc::json_get_optional_uint64(data, "offset").value_or(0));
+        const uint64_t count = std::min<uint64_t>({total - offset, MAX_EVENTS_PER_MESSAGE,
+            wf::ipc::json_get_optional_uint64(data, "count").value_or(MAX_EVENTS_PER_MESSAGE)});
+
+        auto response = wf::ipc::json_ok();
+        response["events"] = wf::json_t::array();
+        for (uint64_t i = offset; i < offset + count; i++)
+        {
+            response["events"].append(recorded_events[i]);
+        }
+
+        response["total"] = total;
+        return response;
+    };
+
+    struct replay_event_t
+    {
+        int64_t time;
+        std::string method;
+        wf::json_t data;
+    };
+
+    std::vector<replay_event_t> replay_events;
+    // Events loaded with "append" for the next replay.
+    std::vector<replay_event_t> loaded_events;
+    size_t replay_next = 0;
+    bool replay_realtime = false;
+    // Number of events dispatched per tick when not replaying in real time.
+    size_t replay_batch  = 64;
+    int64_t replay_start = 0;
+    int replay_errors    = 0;
+    wf::wl_timer<true> replay_timer;
+
+    // Frame statistics of the current or last replay, in microseconds.
+    std::vector<int64_t> frame_times;
+    std::vector<int64_t> input_latencies;
+    int64_t frame_start_us = -1;
+    // When the first input event which has not been displayed yet was dispatched.
+    int64_t pending_input_us = -1;
+
+    wf::signal::connection_t<wf::render_pass_begin_signal> on_replay_frame_begin =
+        [=] (wf::render_pass_begin_signal*)
+    {
+        frame_start_us = wf::get_current_time_us();
+    };
+
+    wf::signal::connection_t<wf::render_pass_end_signal> on_replay_frame_end =
+        [=] (wf::render_pass_end_signal*)
+    {
+        const int64_t now = wf::get_current_time_us();
+        if (frame_start_us >= 0)
+        {
+            frame_times.push_back(now - frame_start_us);
+            frame_start_us = -1;
+        }
+
+        if (pending_input_us >= 0)
+        {
+            input_latencies.push_back(now - pending_input_us);
+            pending_input_us = -1;
+        }
+    };
+
+    void dispatch_replay_event(const replay_event_t& event)
+    {
+        if ((event.method != "stipc/layout_views") && (pending_input_us < 0))
+        {
+            pending_input_us = wf::get_current_time_us();
+        }
+
+        auto result = method_repository->call_method(event.method, event.data);
+        if (result.has_member("error"))
+        {
+            ++replay_errors;
+            LOGE("stipc: failed to replay ", event.method, ": ", (std::string)result["error"]);
+        }
+    }
+
+    /**
+     * Dispatch the next events of the replay, called every millisecond. In real-time mode, all events which
+     * are due are dispatched. Otherwise, up to replay_batch events are dispatched per tick. The timer (and
+     * not an idle callback, which would be re-run before the loop polls again) makes sure that clients and
+     * the render loop get a chance to react between batches.
+     *
+     * @return Whether there are more events to replay.
+     */
+    bool continue_replay()
+    {
+        if (replay_realtime)
+        {
+            const int64_t elapsed = wf::get_current_time() - replay_start;
+            while ((replay_next < replay_events.size()) && (replay_events[replay_next].time <= elapsed))
+            {
+                dispatch_replay_event(replay_events[replay_next++]);
+            }
+        } else
+        {
+            const size_t end = std::min(replay_events.size(), replay_next + replay_batch);
+            while (replay_next < end)
+            {
+                dispatch_replay_event(replay_events[replay_next++]);
+            }
+        }
+
+        if (replay_next < replay_events.size())
+        {
+            return true;
+        }
+
+        LOGI("stipc: replayed ", replay_events.size(), " events in ", wf::get_current_time() - replay_start,
+            "ms, ", frame_times.size(), " frames, ", replay_errors, " errors");
+        return false;
+    }
+
+    /**
+     * Replay the given events. With "append": true, the events are only loaded, and the next call without
+     * it adds its own events and starts the replay of all of them, so that sessions which do not fit in one
+     * IPC message can be replayed.
+     */
+    ipc::method_callback replay = [=] (wf::json_t data)
+    {
+        if (replay_next < replay_events.size())
+        {
+            return wf::ipc::json_error("A replay is already running");
+        }
+
+        if (!data.has_member("events") || !data["events"].is_array())
+        {
+            return wf::ipc::json_error("Events not specified");
+        }
+
+        std::vector<replay_event_t> events;
+        for (size_t i = 0; i < data["events"].size(); i++)
+        {
+            const auto& ev = data["events"][i];
+            if (!ev.has_member("data") || !ev["data"].is_object())
+            {
+                return wf::ipc::json_error("Event " + std::to_string(i) + " has no data");
+            }
+
+            auto method = wf::ipc::json_get_string(ev, "method");
+            if ((method.rfind("stipc/", 0) != 0) || (method.rfind("stipc/record/", 0) == 0) ||
+                (method.rfind("stipc/replay", 0) == 0))
+            {
+                return wf::ipc::json_error("Cannot replay method " + method);
+            }
+
+            events.push_back({wf::ipc::json_get_int64(ev, "time"), method, ev["data"]});
+        }
+
+        loaded_events.insert(loaded_events.end(), std::make_move_iterator(events.begin()),
+            std::make_move_iterator(events.end()));
+        if (wf::ipc::json_get_optional_bool(data, "append").value_or(false))
+        {
+            auto response = wf::ipc::json_ok();
+            response["events"] = (uint64_t)loaded_events.size();
+            return response;
+        }
+
+        replay_events   = std::move(loaded_events);
+        loaded_events   = {};
+        replay_next     = 0;
+        replay_realtime = wf::ipc::json_get_optional_bool(data, "realtime").value_or(false);
+        replay_batch    = std::max<int64_t>(1, wf::ipc::json_get_optional_int64(data, "batch").value_or(64));
+        replay_start    = wf::get_current_time();
+        replay_errors   = 0;
+        frame_times.clear();
+        input_latencies.clear();
+        frame_start_us   = -1;
+        pending_input_us = -1;
+
+        if (!on_replay_frame_begin.is_connected())
+        {
+            wf::get_core().connect(&on_replay_frame_begin);
+            wf::get_core().connect(&on_replay_frame_end);
+        }
+
+        replay_timer.set_timeout(1, [=] { return continue_replay(); });
+        auto response = wf::ipc::json_ok();
+        response["events"] = replay_events.size();
+        return response;
+    };
+
+    static wf::json_t summarize(std::vector<int64_t> values)
+    {
+        wf::json_t summary;
+        if (values.empty())
+        {
+            return summary;
+        }
+
+        std::sort(values.begin(), values.end());
+        int64_t sum = 0;
+        for (auto v : values)
+        {
+            sum += v;
+        }
+
+        summary["avg"] = sum / (int64_t)values.size();
+        summary["p50"] = values[values.size() / 2];
+        summary["p95"] = values[std::min(values.size() - 1, values.size() * 95 / 100)];
+        summary["max"] = values.back();
+        return summary;
+    }
+
+    /**
+     * Statistics of the current or last replay: the time spent rendering each frame, and the time from
+     * dispatching an input event until the end of the next frame. All times are in microseconds.
+     */
+    ipc::method_callback replay_stats = [=] (wf::json_t)
+    {
+        auto response = wf::ipc::json_ok();
+        response["done"]   = (replay_next >= replay_events.size());
+        response["events"] = replay_next;
+        response["errors"] = replay_errors;
+        response["frames"] = frame_times.size();
+        response["frame-time-us"]    = summarize(frame_times);
+        response["input-latency-us"] = summarize(input_latencies);
+        return response;
+    };
+
     std::unique_ptr<headless_input_backend_t> input;
 };
 }
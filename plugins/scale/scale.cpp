@@ -145,6 +145,7 @@ class wayfire_scale : public wf::per_output_plugin_instance_t,
     {
         hook_set = false;
         grab     = std::make_unique<wf::input_grab_t>(SCALE_TRANSFORMER, output, this, this, this);
+        grab->set_coalesce_motion(true);
 
         allow_scale_zoom.set_callback(allow_scale_zoom_option_changed);
 
@@ -125,6 +125,7 @@ class wayfire_expo : public wf::per_output_plugin_instance_t, public wf::keyboar
     void init() override
     {
         input_grab = std::make_unique<wf::input_grab_t>("expo", output, this, this, this);
+        input_grab->set_coalesce_motion(true);
 
         setup_workspace_bindings_from_config();
         wall = std::make_unique<wf::workspace_wall_t>(this->output);
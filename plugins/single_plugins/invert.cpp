@@ -3,53 +3,30 @@
 #include <wayfire/opengl.hpp>
 #include <wayfire/render-manager.hpp>
 
-static const char *vertex_shader =
+static const char *invert_source =
     R"(
-#version 100
+uniform bool @preserve_hue;
 
-attribute highp vec2 position;
-attribute highp vec2 uvPosition;
-
-varying highp vec2 uvpos;
-
-void main() {
-
-    gl_Position = vec4(position.xy, 0.0, 1.0);
-    uvpos = uvPosition;
-}
-)";
-
-static const char *fragment_shader =
-    R"(
-#version 100
-
-varying highp vec2 uvpos;
-uniform sampler2D smp;
-uniform bool preserve_hue;
-
-void main()
+highp vec4 @apply(highp vec4 tex)
 {
-    highp vec4 tex = texture2D(smp, uvpos);
-
-    if (preserve_hue)
+    if (@preserve_hue)
     {
         highp float hue = tex.a - min(tex.r, min(tex.g, tex.b)) - max(tex.r, max(tex.g, tex.b));
-        gl_FragColor = hue + tex;
+        return hue + tex;
     } else
     {
-        gl_FragColor = vec4(1.0 - tex.r, 1.0 - tex.g, 1.0 - tex.b, 1.0);
+        return vec4(1.0 - tex.r, 1.0 - tex.g, 1.0 - tex.b, 1.0);
     }
 }
 )";
 
 class wayfire_invert_screen : public wf::per_output_plugin_instance_t
 {
-    wf::post_hook_t hook;
+    wf::post_fragment_effect_t effect;
     wf::activator_callback toggle_cb;
     wf::option_wrapper_t<bool> preserve_hue{"invert/preserve_hue"};
 
     bool active = false;
-    OpenGL::program_t program;
 
     wf::plugin_activation_data_t grab_interface = {
         .name = "invert",
@@ -69,12 +46,20 @@ class wayfire_invert_screen : public wf::per_output_plugin_instance_t
 
         wf::option_wrapper_t<wf::activatorbinding_t> toggle_key{"invert/toggle"};
 
-        hook = [=] (wf::auxilliary_buffer_t& source,
-                    const wf::render_buffer_t& destination)
+        effect.source = invert_source;
+        effect.set_uniforms = [=] (OpenGL::program_t& program, const std::string& prefix)
         {
-            render(source, destination);
+            program.uniform1i(prefix + "preserve_hue", preserve_hue);
         };
 
+        preserve_hue.set_callback([=] ()
+        {
+            if (active)
+            {
+                output->render->damage_whole();
+            }
+        });
+
         toggle_cb = [=] (auto)
         {
             if (!output->can_activate_plugin(&grab_interface))
@@ -84,10 +69,10 @@ class wayfire_invert_screen : public wf::per_output_plugin_instance_t
 
             if (active)
             {
-                output->render->rem_post(&hook);
+                output->render->rem_post(&effect);
             } else
             {
-                output->render->add_post(&hook);
+                output->render->add_post(&effect);
             }
 
             active = !active;
@@ -95,62 +80,16 @@ class wayfire_invert_screen : public wf::per_output_plugin_instance_t
             return true;
         };
 
-        wf::gles::run_in_context([&]
-        {
-            program.set_simple(OpenGL::compile_program(vertex_shader, fragment_shader));
-        });
-
         output->add_activator(toggle_key, &toggle_cb);
     }
 
-    void render(wf::auxilliary_buffer_t& source, const wf::render_buffer_t& destination)
-    {
-        static const float vertexData[] = {
-            -1.0f, -1.0f,
-            1.0f, -1.0f,
-            1.0f, 1.0f,
-            -1.0f, 1.0f
-        };
-
-        static const float coordData[] = {
-            0.0f, 0.0f,
-            1.0f, 0.0f,
-            1.0f, 1.0f,
-            0.0f, 1.0f
-        };
-
-        wf::gles::run_in_context([&]
-        {
-            wf::gles::bind_render_buffer(destination);
-            program.use(wf::TEXTURE_TYPE_RGBA);
-            GL_CALL(glBindTexture(GL_TEXTURE_2D, wf::gles_texture_t::from_aux(source).tex_id));
-            GL_CALL(glActiveTexture(GL_TEXTURE0));
-
-            program.attrib_pointer("position", 2, 0, vertexData);
-            program.attrib_pointer("uvPosition", 2, 0, coordData);
-            program.uniform1i("preserve_hue", preserve_hue);
-
-            GL_CALL(glDisable(GL_BLEND));
-            GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
-            GL_CALL(glEnable(GL_BLEND));
-            GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-
-            program.deactivate();
-        });
-    }
-
     void fini() override
     {
         if (active)
         {
-            output->render->rem_post(&hook);
+            output->render->rem_post(&effect);
         }
 
-        wf::gles::run_in_context_if_gles([&]
-        {
-            program.free_resources();
-        });
-
         output->rem_binding(&toggle_cb);
     }
 };
@@ -40,6 +40,7 @@ class wayfire_move : public wf::per_output_plugin_instance_t,
 
     wf::option_wrapper_t<bool> move_enable_snap_off{"move/enable_snap_off"};
     wf::option_wrapper_t<int> move_snap_off_threshold{"move/snap_off_threshold"};
+    wf::option_wrapper_t<bool> snapshot_drag{"move/snapshot_drag"};
 
     struct
     {
@@ -178,6 +179,7 @@ class wayfire_move : public wf::per_output_plugin_instance_t,
 
         input_grab = std::make_unique<wf::input_grab_t>("move", output, nullptr, this, this);
         input_grab->set_wants_raw_input(true);
+        input_grab->set_coalesce_motion(true);
 
         activate_binding = [=] (auto)
         {
@@ -349,6 +351,7 @@ class wayfire_move : public wf::per_output_plugin_instance_t,
             (view->pending_fullscreen() || view->pending_tiled_edges());
         opts.snap_off_threshold = move_snap_off_threshold;
         opts.join_views = join_views;
+        opts.snapshot   = snapshot_drag;
 
         if (join_views)
         {
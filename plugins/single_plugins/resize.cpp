@@ -3,7 +3,9 @@
 #include "wayfire/scene-input.hpp"
 #include "wayfire/txn/transaction-manager.hpp"
 #include <wayfire/toplevel.hpp>
+#include <wayfire/view-transform.hpp>
 #include <cmath>
+#include <optional>
 #include <wayfire/per-output-plugin.hpp>
 #include <wayfire/output.hpp>
 #include <wayfire/view.hpp>
@@ -45,11 +47,49 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
     {
         if (ev->view == view)
         {
+            remove_preview();
             view = nullptr;
             input_pressed(WLR_BUTTON_RELEASED);
         }
     };
 
+    /*
+     * Resizing sends at most one configure to the client at a time: while the client has not yet acked and
+     * committed the previous size (i.e. a transaction for its toplevel is still in flight), new motion only
+     * updates target_geometry, which is sent once that transaction is applied. In the meantime, the last
+     * committed buffer is scaled to the target geometry, so the view still follows the pointer.
+     */
+    std::optional<wf::geometry_t> target_geometry;
+    static constexpr const char *preview_transformer_name = "resize-preview";
+
+    wf::signal::connection_t<wf::txn::transaction_applied_signal> on_resize_applied =
+        [=] (wf::txn::transaction_applied_signal *ev)
+    {
+        const auto& objects = ev->self->get_objects();
+        if (view && (std::find(objects.begin(), objects.end(), view->toplevel()) != objects.end()))
+        {
+            send_target_geometry();
+        }
+    };
+
+    /*
+     * The transaction with the last configure may be merged into, or replaced by, another transaction which
+     * contains the toplevel. Objects may also be merged into a transaction after it is announced, so during
+     * the grab every transaction is watched, and the queued target is sent once any transaction with the
+     * toplevel has been applied.
+     */
+    wf::signal::connection_t<wf::txn::new_transaction_signal> on_new_tx =
+        [=] (wf::txn::new_transaction_signal *ev)
+    {
+        ev->tx->connect(&on_resize_applied);
+    };
+
+    wf::signal::connection_t<wf::view_geometry_changed_signal> on_view_geometry_changed =
+        [=] (wf::view_geometry_changed_signal *ev)
+    {
+        update_preview();
+    };
+
     wf::button_callback activate_binding;
     wf::button_callback activate_binding_preserve_aspect;
 
@@ -67,6 +107,7 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
     wf::option_wrapper_t<wf::buttonbinding_t> button{"resize/activate"};
     wf::option_wrapper_t<wf::buttonbinding_t> button_preserve_aspect{
         "resize/activate_preserve_aspect"};
+    wf::option_wrapper_t<bool> scaled_preview{"resize/scaled_preview"};
     std::unique_ptr<wf::input_grab_t> input_grab;
     wf::plugin_activation_data_t grab_interface = {
         .name = "resize",
@@ -77,6 +118,7 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
     void init() override
     {
         input_grab = std::make_unique<wf::input_grab_t>("resize", output, nullptr, this, this);
+        input_grab->set_coalesce_motion(true);
 
         activate_binding = [=] (auto)
         {
@@ -232,6 +274,9 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
         }
 
         this->view = view;
+        target_geometry.reset();
+        view->connect(&on_view_geometry_changed);
+        wf::get_core().tx_manager->connect(&on_new_tx);
 
         auto og = view->get_bounding_box();
         int anchor_x = og.x;
@@ -262,9 +307,15 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
 
         input_grab->ungrab_input();
         output->deactivate_plugin(&grab_interface);
+        on_view_geometry_changed.disconnect();
 
+        // The last target is sent right away, no need to wait for the transactions anymore.
+        on_new_tx.disconnect();
+        on_resize_applied.disconnect();
         if (view)
         {
+            send_target_geometry();
+            remove_preview();
             end_wobbly(view);
 
             wf::view_change_workspace_signal workspace_may_changed;
@@ -442,11 +493,78 @@ class wayfire_resize : public wf::per_output_plugin_instance_t, public wf::point
             desired.y += desired_unconstrained.height - desired.height;
         }
 
-        if (wf::dimensions(view->toplevel()->pending().geometry) != wf::dimensions(desired))
+        auto current_target = target_geometry.value_or(view->toplevel()->pending().geometry);
+        if (wf::dimensions(current_target) == wf::dimensions(desired))
+        {
+            return;
+        }
+
+        target_geometry = desired;
+        auto& tx_manager = wf::get_core().tx_manager;
+        if (!tx_manager->is_object_pending(view->toplevel()) &&
+            !tx_manager->is_object_committed(view->toplevel()))
+        {
+            send_target_geometry();
+        }
+
+        update_preview();
+    }
+
+    /** Send the target geometry to the client, if it has changed since the last configure. */
+    void send_target_geometry()
+    {
+        if (!view || !target_geometry)
+        {
+            return;
+        }
+
+        view->toplevel()->pending().gravity  = calculate_gravity();
+        view->toplevel()->pending().geometry = *target_geometry;
+        target_geometry.reset();
+
+        auto tx = wf::txn::transaction_t::create();
+        tx->add_object(view->toplevel());
+        wf::get_core().tx_manager->schedule_transaction(std::move(tx));
+    }
+
+    /** Scale the view from its current geometry to the geometry it will have once the client catches up. */
+    void update_preview()
+    {
+        if (!view || !scaled_preview)
+        {
+            return;
+        }
+
+        auto current = view->get_geometry();
+        auto target  = target_geometry.value_or(view->toplevel()->pending().geometry);
+        if ((current.width <= 0) || (current.height <= 0) ||
+            (wf::dimensions(current) == wf::dimensions(target)))
+        {
+            remove_preview();
+            return;
+        }
+
+        auto tmanager = view->get_transformed_node();
+        auto tr = tmanager->get_transformer<wf::scene::view_2d_transformer_t>(preview_transformer_name);
+        if (!tr)
+        {
+            tr = std::make_shared<wf::scene::view_2d_transformer_t>(view);
+            tmanager->add_transformer(tr, wf::TRANSFORMER_2D, preview_transformer_name);
+        }
+
+        tmanager->begin_transform_update();
+        tr->scale_x = 1.0 * target.width / current.width;
+        tr->scale_y = 1.0 * target.height / current.height;
+        tr->translation_x = (target.x + target.width / 2.0) - (current.x + current.width / 2.0);
+        tr->translation_y = (target.y + target.height / 2.0) - (current.y + current.height / 2.0);
+        tmanager->end_transform_update();
+    }
+
+    void remove_preview()
+    {
+        if (view)
         {
-            view->toplevel()->pending().gravity  = calculate_gravity();
-            view->toplevel()->pending().geometry = desired;
-            wf::get_core().tx_manager->schedule_object(view->toplevel());
+            view->get_transformed_node()->rem_transformer(preview_transformer_name);
         }
     }
 
@@ -2,6 +2,7 @@
 #include <wayfire/output.hpp>
 #include <wayfire/render.hpp>
 #include <wayfire/render-manager.hpp>
+#include <wayfire/signal-definitions.hpp>
 #include <wayfire/util/duration.hpp>
 
 class wayfire_zoom_screen : public wf::per_output_plugin_instance_t
@@ -18,6 +19,7 @@ class wayfire_zoom_screen : public wf::per_output_plugin_instance_t
     wf::option_wrapper_t<int> interpolation_method{"zoom/interpolation_method"};
     wf::animation::simple_animation_t progression{smoothing_duration};
     bool hook_set = false;
+    bool animating = false;
 
     wf::plugin_activation_data_t grab_interface = {
         .name = "zoom",
@@ -40,13 +42,8 @@ class wayfire_zoom_screen : public wf::per_output_plugin_instance_t
         if (target != progression.end)
         {
             progression.animate(target);
-
-            if (!hook_set)
-            {
-                hook_set = true;
-                output->render->add_post(&render_hook);
-                output->render->set_redraw_always();
-            }
+            set_hook();
+            set_animating(true);
         }
     }
 
@@ -67,15 +64,39 @@ class wayfire_zoom_screen : public wf::per_output_plugin_instance_t
         return true;
     };
 
-    wf::post_hook_t render_hook = [=] (wf::auxilliary_buffer_t& source,
-                                       const wf::render_buffer_t& destination)
+    /**
+     * The zoomed area follows the cursor, so we need a new frame whenever it moves. The frame is cheap if
+     * the zoomed area did not actually change, since then nothing is damaged.
+     */
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_pointer_motion_event>> on_motion =
+        [=] (auto)
+    {
+        output->render->schedule_redraw();
+    };
+
+    wf::signal::connection_t<wf::post_input_event_signal<wlr_pointer_motion_absolute_event>>
+    on_motion_absolute = [=] (auto)
+    {
+        output->render->schedule_redraw();
+    };
+
+    /**
+     * Update the zoomed area before each frame. Instead of scaling the rendered output, the render manager
+     * renders only the zoomed area of the scene, at the magnified scale.
+     */
+    wf::effect_hook_t pre_hook = [=] ()
     {
-        auto w = destination.get_size().width;
-        auto h = destination.get_size().height;
-        if ((w <= 0) || (h <= 0))
+        // Store progression once to avoid its value changing in subsequent calls, could be very tricky due to
+        // timing. And if we use slightly different progressions, we can get an invalid rect.
+        const double factor = progression;
+        if (!progression.running())
         {
-            LOGE("Invalid output size in zoom plugin!");
-            return;
+            set_animating(false);
+            if (factor - 1 <= 0.01)
+            {
+                unset_hook();
+                return;
+            }
         }
 
         auto oc = output->get_cursor_position();
@@ -83,43 +104,53 @@ class wayfire_zoom_screen : public wf::per_output_plugin_instance_t
         wlr_box b = output->get_relative_geometry();
         wlr_box_closest_point(&b, oc.x, oc.y, &x, &y);
 
-        /* get rotation & scale */
-        wlr_box box = {int(x), int(y), 1, 1};
-        box = output->render->get_target_framebuffer().framebuffer_box_from_geometry_box(box);
-        x   = box.x;
-        y   = box.y;
-
-        // Store progression once to avoid its value changing in subsequent calls, could be very tricky due to
-        // timing. And if we use slightly different progressions, we can get an invalid rect.
-        const float factor = (float)progression;
-        const float scale  = (factor - 1) / factor;
-        const float x1     = std::clamp(float(x * scale), 0.0f, w - 1.0f);
-        const float y1     = std::clamp(float(y * scale), 0.0f, h - 1.0f);
-        const float tw     = std::clamp(w / factor, 0.0f, w - x1);
-        const float th     = std::clamp(h / factor, 0.0f, h - y1);
+        const double scale = (factor - 1) / factor;
         auto filter_mode   = (interpolation_method == (int)interpolation_method_t::NEAREST) ?
             WLR_SCALE_FILTER_NEAREST : WLR_SCALE_FILTER_BILINEAR;
-        destination.blit(source, {x1, y1, tw, th}, {0, 0, w, h}, filter_mode);
-        if (!progression.running() && (progression - 1 <= 0.01))
+        output->render->set_viewport(wlr_fbox{x * scale, y * scale, b.width / factor, b.height / factor},
+            filter_mode);
+    };
+
+    void set_hook()
+    {
+        if (hook_set)
         {
-            unset_hook();
+            return;
         }
-    };
+
+        hook_set = true;
+        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        wf::get_core().connect(&on_motion);
+        wf::get_core().connect(&on_motion_absolute);
+    }
 
     void unset_hook()
     {
-        output->render->set_redraw_always(false);
-        output->render->rem_post(&render_hook);
+        if (!hook_set)
+        {
+            return;
+        }
+
+        set_animating(false);
+        output->render->set_viewport(std::nullopt);
+        output->render->rem_effect(&pre_hook);
+        on_motion.disconnect();
+        on_motion_absolute.disconnect();
         hook_set = false;
     }
 
-    void fini() override
+    void set_animating(bool animate)
     {
-        if (hook_set)
+        if (animating != animate)
         {
-            output->render->rem_post(&render_hook);
+            animating = animate;
+            output->render->set_redraw_always(animate);
         }
+    }
 
+    void fini() override
+    {
+        unset_hook();
         output->rem_binding(&axis);
     }
 };
@@ -21,6 +21,7 @@ class toplevel_view_interface_t;
 class window_manager_t;
 class workspace_set_t;
 class config_backend_t;
+class worker_pool_t;
 
 namespace scene
 {
@@ -157,6 +158,7 @@ class compositor_core_t : public wf::object_base_t, public signal::provider_t
     std::unique_ptr<wf::seat_t> seat;
     std::unique_ptr<wf::txn::transaction_manager_t> tx_manager;
     std::unique_ptr<wf::window_manager_t> default_wm;
+    std::unique_ptr<wf::worker_pool_t> workers;
 
     /**
      * Various protocols supported by wlroots
@@ -169,7 +171,9 @@ class compositor_core_t : public wf::object_base_t, public signal::provider_t
         wlr_screencopy_manager_v1 *screencopy;
         wlr_ext_foreign_toplevel_list_v1 *foreign_toplevel_list;
         wlr_ext_image_copy_capture_manager_v1 *image_copy_capture;
-        wlr_ext_output_image_capture_source_manager_v1 *image_capture_source;
+        /* Output capture sources are implemented by core instead of wlroots, so this is always NULL. */
+        [[deprecated("Output capture sources are implemented by core, see output_capture_stats_t")]]
+        wlr_ext_output_image_capture_source_manager_v1 *image_capture_source = NULL;
         wlr_export_dmabuf_manager_v1 *export_dmabuf;
         wlr_server_decoration_manager *decorator_manager;
         wlr_xdg_decoration_manager_v1 *xdg_decorator;
@@ -186,6 +190,9 @@ class compositor_core_t : public wf::object_base_t, public signal::provider_t
         wlr_input_method_manager_v2 *input_method = NULL;
         wlr_text_input_manager_v3 *text_input     = NULL;
         wlr_presentation *presentation;
+        wlr_fifo_manager_v1 *fifo;
+        wlr_commit_timing_manager_v1 *commit_timing;
+        wlr_content_type_manager_v1 *content_type;
         wlr_primary_selection_v1_device_manager *primary_selection_v1;
         wlr_viewporter *viewporter;
         wlr_drm_lease_v1_manager *drm_v1;
@@ -2,21 +2,74 @@
 #define IMG_HPP_
 
 #include <wayfire/opengl.hpp>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace image_io
 {
+/* An image decoded to 8-bit RGB or RGBA pixels, with tightly packed rows */
+struct decoded_image_t
+{
+    int width    = 0;
+    int height   = 0;
+    int channels = 4;
+    std::vector<uint8_t> pixels;
+};
+
+using decoded_image_ptr = std::shared_ptr<const decoded_image_t>;
+
 /* Load the image from the given file, binding it to the given GL texture target
  * Bind the texture before you call this function
  * Guaranteed: doesn't change any GL state except pixel packing */
 bool load_from_file(std::string name, GLuint target);
 
+/* Decode the image from the given file on a worker thread, without blocking the compositor.
+ * on_done is called on the main thread with the decoded image, or nullptr if loading failed.
+ *
+ * Decoded images are shared by the hash of the file contents while they are in use, so an image loaded
+ * by several outputs or plugins at the same time is decoded only once. Drop the image after uploading it,
+ * so that its pixels are freed. */
+void load_from_file_async(std::string name, std::function<void(decoded_image_ptr)> on_done);
+
+/* Upload a decoded image to the texture bound to the given GL texture target
+ * (GL_TEXTURE_2D, or GL_TEXTURE_CUBE_MAP for cubemap images).
+ * Guaranteed: doesn't change any GL state except pixel packing */
+bool upload_to_texture(const decoded_image_t& image, GLuint target);
+
 /* Function that saves the given pixels(in rgba format) to a (currently) png file */
 void write_to_file(std::string name, uint8_t *pixels, int w, int h,
     std::string type, bool invert = false);
 
 void write_to_file(std::string name, const wf::render_buffer_t& buffer);
 
+/* Compression levels for write_to_file_async(), as in zlib */
+constexpr int COMPRESSION_DEFAULT = -1;
+constexpr int COMPRESSION_NONE    = 0;
+constexpr int COMPRESSION_FAST    = 1;
+constexpr int COMPRESSION_BEST    = 9;
+
+/* Emitted on core when a file written with write_to_file_async() has been written, or writing failed. */
+struct write_done_signal
+{
+    std::string name;
+    bool success;
+};
+
+/* Save the given pixels (in rgba format) to a png file, encoding them on a worker thread.
+ * The pixel buffer is owned by the writer from now on. compression_level is between
+ * COMPRESSION_NONE and COMPRESSION_BEST, or COMPRESSION_DEFAULT. Levels up to COMPRESSION_FAST
+ * also disable row filtering, which makes encoding of large outputs considerably faster.
+ *
+ * Completion is reported with write_done_signal, emitted on the main thread. */
+void write_to_file_async(std::string name, std::vector<uint8_t> pixels, int w, int h,
+    int compression_level = COMPRESSION_DEFAULT, bool invert = false);
+
+/* Read back the buffer on the main thread and save it asynchronously, see above */
+void write_to_file_async(std::string name, const wf::render_buffer_t& buffer,
+    int compression_level = COMPRESSION_DEFAULT);
+
 /* Initializes all backends, called at startup */
 void init();
 }
@@ -51,6 +51,11 @@ extern "C"
 
 #include <wlr/types/wlr_damage_ring.h>
 #include <wlr/types/wlr_presentation_time.h>
+#include <wlr/types/wlr_fifo_v1.h>
+#include <wlr/types/wlr_commit_timing_v1.h>
+#if  __has_include(<content-type-v1-protocol.h>)
+    #include <wlr/types/wlr_content_type_v1.h>
+#endif
 #include <wlr/util/region.h>
 #include <wlr/util/transform.h>
 #include <wlr/types/wlr_screencopy_v1.h>
@@ -39,6 +39,9 @@ extern "C"
     struct wlr_input_method_manager_v2;
     struct wlr_text_input_manager_v3;
     struct wlr_presentation;
+    struct wlr_fifo_manager_v1;
+    struct wlr_commit_timing_manager_v1;
+    struct wlr_content_type_manager_v1;
     struct wlr_primary_selection_v1_device_manager;
     struct wlr_drm_lease_v1_manager;
     struct wlr_session_lock_manager_v1;
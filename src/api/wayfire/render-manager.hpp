@@ -4,6 +4,15 @@
 #include <wayfire/output.hpp>
 #include <wayfire/object.hpp>
 #include <wayfire/region.hpp>
+#include <wayfire/scene-render.hpp>
+#include <array>
+#include <memory>
+#include <string>
+
+namespace OpenGL
+{
+class program_t;
+}
 
 namespace wf
 {
@@ -51,6 +60,81 @@ enum output_effect_type_t
 using post_hook_t = std::function<void (wf::auxilliary_buffer_t& source,
     const wf::render_buffer_t& destination)>;
 
+/**
+ * A post-processing effect which computes the color of each pixel only from the color of the same pixel
+ * in the source image (color inversion, color filters, etc.).
+ *
+ * In contrast to post_hook_t, such effects do not need a render pass and an intermediate buffer each:
+ * consecutive fragment effects are fused into a single shader pass. Since they are damage-local, core
+ * also runs them only on the damaged parts of the output, instead of repainting the whole output each
+ * frame. Fragment effects are supported only with the GLES renderer.
+ */
+struct post_fragment_effect_t
+{
+    /**
+     * GLSL (ES 1.00) source code of the effect. It must define the function
+     * `highp vec4 @apply(highp vec4 color)`, which returns the processed color.
+     *
+     * Each occurrence of `@` is replaced with a prefix unique to the effect, so it should also be used for
+     * uniforms and helper functions (e.g. `uniform bool @preserve_hue;`), to avoid clashes with other
+     * effects fused into the same shader.
+     */
+    std::string source;
+
+    /**
+     * Set the uniforms of the effect, if any. Called with the fused program already in use.
+     * The prefix is the string `@` was replaced with.
+     */
+    std::function<void (OpenGL::program_t& program, const std::string& prefix)> set_uniforms;
+};
+
+/**
+ * Describes a surface which commits new buffers at a stable rate (e.g. a video player or a game), used to
+ * predict when the next commit is going to arrive.
+ */
+struct commit_cadence_t
+{
+    /** Time of the last commit, in microseconds, see wf::get_current_time_us(). */
+    int64_t last_commit_us;
+    /** Time between two commits, in microseconds. */
+    int64_t period_us;
+};
+
+/**
+ * Statistics about the direct scanout attempts on an output.
+ */
+struct direct_scanout_stats_t
+{
+    /** Number of frames for which direct scanout was attempted, i.e. all frames of the output. */
+    uint64_t attempts  = 0;
+    /** Number of frames which were directly scanned out. */
+    uint64_t successes = 0;
+
+    /** Why the last attempt failed, or NONE if it succeeded. */
+    scene::scanout_blocker_t last_blocker = scene::scanout_blocker_t::NONE;
+    /** The node which blocked the last attempt, if any and if it still exists. */
+    std::weak_ptr<scene::node_t> last_blocker_node;
+
+    /** How many attempts failed for each reason, indexed by scanout_blocker_t. */
+    std::array<uint64_t, scene::SCANOUT_BLOCKER_COUNT> blockers = {};
+};
+
+/**
+ * The kind of content shown on an output, as hinted by its fullscreen or focused surface (via the
+ * wp_content_type_v1 protocol). The render manager adapts the scheduling of repaints to it.
+ */
+enum class output_content_type_t
+{
+    /** No hint, or content-type-aware scheduling is disabled on the output. */
+    NONE,
+    /** Still images: repaints start as late as the frame deadline allows, batching client updates. */
+    PHOTO,
+    /** Video playback: repaints are aligned with the commits of the video, scanout is tried more eagerly. */
+    VIDEO,
+    /** Games and other latency-sensitive content: the repaint delay is disabled. */
+    GAME,
+};
+
 /**
  * The frame-done signal is emitted on an output when the frame has been completed (regardless of whether new
  * content was painted or not).
@@ -90,6 +174,32 @@ class render_manager
      */
     void schedule_redraw();
 
+    /**
+     * Let the render manager know that a surface visible on the output commits at a stable cadence. When
+     * the workarounds/cadence_aligned_repaint option is enabled (or the output shows a video, see
+     * get_content_type()), the start of the repaint is then delayed
+     * (within the repaint delay budget) until just after the next predicted commit, so that the new buffer
+     * makes it into the upcoming frame instead of the one after it.
+     *
+     * @param source An identifier of the surface.
+     * @param cadence The current cadence, or std::nullopt if the surface no longer has a stable cadence
+     *   or is no longer visible. Outdated hints (of surfaces which stopped committing) are dropped
+     *   automatically.
+     */
+    void set_commit_cadence(const void *source, std::optional<commit_cadence_t> cadence);
+
+    /**
+     * @return The content type the output currently schedules its repaints for. It is updated at the
+     *   start of each frame, based on the output's content_type_scheduling option.
+     */
+    output_content_type_t get_content_type() const;
+
+    /**
+     * @return Statistics about the direct scanout attempts on the output. Changes of the blocking reason
+     *   are also logged with the scanout debug category.
+     */
+    const direct_scanout_stats_t& get_direct_scanout_stats() const;
+
     /**
      * Inhibit rendering to the output. An inhibited output will show a
      * fully black image. Used mainly for compositor fade in/out on startup.
@@ -122,6 +232,24 @@ class render_manager
      */
     void rem_post(post_hook_t *hook);
 
+    /**
+     * Add a new per-pixel post-processing effect. Fragment effects are ordered together with the post hooks
+     * added with the other overload of add_post().
+     *
+     * Note that the output is not repainted when the result of the effect changes (e.g. its uniforms
+     * change), the plugin should damage the output in this case.
+     *
+     * @param effect The effect to add. It should stay valid until it is removed.
+     */
+    void add_post(post_fragment_effect_t *effect);
+
+    /**
+     * Remove a per-pixel post-processing effect. No-op if the effect isn't active.
+     *
+     * @param effect The effect to be removed.
+     */
+    void rem_post(post_fragment_effect_t *effect);
+
     /**
      * @return The damaged region on the current output for the current
      * frame that is used when swapping buffers. This function should
@@ -188,6 +316,21 @@ class render_manager
      */
     wf::render_target_t get_target_framebuffer() const;
 
+    /**
+     * Show only a part of the output, magnified so that it fills the whole output.
+     *
+     * In contrast to a post hook which scales the rendered image, the scene is rendered directly at the
+     * magnified scale: only the visible part of the scene is painted and damage tracking keeps working.
+     * Changing the viewport damages the whole output. Direct scanout is disabled while a viewport is set.
+     *
+     * @param viewport The part of the output to show, in output-local logical coordinates, or std::nullopt
+     *   to show the whole output again. The viewport is scaled uniformly based on its width, so it should
+     *   have the same aspect ratio as the output.
+     * @param filter_mode The filter used to scale the contents of the scene.
+     */
+    void set_viewport(std::optional<wlr_fbox> viewport,
+        wlr_scale_filter_mode filter_mode = WLR_SCALE_FILTER_BILINEAR);
+
     /**
      * Inform Wayfire whether a depth buffer is required for rendering on the default framebuffer for each
      * output.
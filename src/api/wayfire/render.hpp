@@ -202,6 +202,10 @@ struct render_target_t : public render_buffer_t
     // Note: (0,0) is top-left for subbuffer.
     std::optional<wf::geometry_t> subbuffer;
 
+    // If set, textures rendered on the target are scaled with this filter, unless they request a filter
+    // mode themselves. Otherwise, the filter is chosen based on the scale.
+    std::optional<wlr_scale_filter_mode> filter_mode;
+
     /**
      * Get a render target which is the same as this, but whose geometry is
      * translated by @offset.
@@ -3,6 +3,7 @@
 #include <memory>
 #include <vector>
 #include <any>
+#include <string>
 #include <wayfire/config/types.hpp>
 #include <wayfire/region.hpp>
 #include <wayfire/geometry.hpp>
@@ -42,6 +43,57 @@ enum class direct_scanout
     SUCCESS,
 };
 
+/**
+ * The reason why direct scanout on an output was not possible, see report_scanout_blocker().
+ */
+enum class scanout_blocker_t
+{
+    /** Direct scanout succeeded. */
+    NONE,
+    /** Rendering on the output is inhibited. */
+    INHIBITED,
+    /** A plugin has active effect hooks on the output. */
+    EFFECT_HOOKS,
+    /** Post-processing effects or a viewport are active on the output. */
+    POST_EFFECTS,
+    /** An ICC color transform is active on the output. */
+    COLOR_TRANSFORM,
+    /** wlroots does not allow direct scanout (e.g. because of software cursors). */
+    NOT_ALLOWED,
+    /** Direct scanout was disabled by WAYFIRE_DISABLE_DIRECT_SCANOUT. */
+    DISABLED,
+    /** No node on the output can be scanned out. */
+    NO_CANDIDATE,
+    /** A node without direct scanout support covers (a part of) the output. */
+    OCCLUDED,
+    /** A node is transformed by a view transformer. */
+    TRANSFORMED,
+    /** The surface does not cover the output exactly. */
+    GEOMETRY,
+    /** The buffer scale or transform of the surface does not match the output. */
+    SCALE_TRANSFORM,
+    /** The surface is not fully opaque. */
+    NOT_OPAQUE,
+    /** The output rejected the buffer of the surface. */
+    BUFFER_REJECTED,
+};
+
+/** The number of values of scanout_blocker_t. */
+constexpr size_t SCANOUT_BLOCKER_COUNT = (size_t)scanout_blocker_t::BUFFER_REJECTED + 1;
+
+/** @return A short human-readable name of the reason. */
+const char *scanout_blocker_to_string(scanout_blocker_t reason);
+
+/**
+ * Record why direct scanout is failing on the output, to be shown in the output's direct scanout
+ * statistics (see render_manager::get_direct_scanout_stats()). Render instances should call this from
+ * try_scanout() before returning OCCLUSION. Only the first reason reported during an attempt is kept,
+ * calls outside of a direct scanout attempt are ignored.
+ *
+ * @param node The blocking node. It is described with stringify() only when the statistics are shown.
+ */
+void report_scanout_blocker(wf::output_t *output, scanout_blocker_t reason, node_t *node);
+
 /**
  * A single rendering call in a render pass.
  */
@@ -209,6 +261,12 @@ class simple_render_instance_t : public render_instance_t
                 });
     }
 
+    direct_scanout try_scanout(wf::output_t *output) override
+    {
+        report_scanout_blocker(output, scanout_blocker_t::OCCLUDED, self.get());
+        return direct_scanout::OCCLUSION;
+    }
+
   protected:
     std::shared_ptr<Node> self;
     wf::signal::connection_t<scene::node_damage_signal> on_self_damage = [=] (scene::node_damage_signal *ev)
@@ -91,6 +91,13 @@ enum class node_flags : int
      * unmatched pointer press/release events, unmatched touch up/down events, etc.
      */
     RAW_INPUT = (1 << 1),
+    /**
+     * If set, pointer motion events for the node are coalesced: instead of receiving every motion event from
+     * the input devices, the node receives handle_pointer_motion() at most once per frame, right before the
+     * output under the cursor is repainted, with the latest cursor position. Pending motion is always
+     * delivered before a button event. Meant for input grabs which redo their layout on each motion.
+     */
+    COALESCE_MOTION = (1 << 2),
 };
 
 using node_flags_bitmask_t = uint64_t;
@@ -0,0 +1,88 @@
+#pragma once
+
+// WF_USE_CONFIG_H is set only when building Wayfire itself, external plugins
+// need to use <wayfire/config.h>
+#ifdef WF_USE_CONFIG_H
+    #include <config.h>
+#else
+    #include <wayfire/config.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace wf
+{
+/**
+ * Lightweight trace points for inspecting what the compositor does in a frame.
+ *
+ * Code is instrumented with WF_TRACE_SCOPE("name"), which records the time spent in the enclosing scope.
+ * Trace points are compiled out unless Wayfire is built with the enable_tracing option, and cost a single
+ * relaxed atomic load while no trace is being recorded.
+ *
+ * A recording is started and stopped over IPC (see the ipc-rules plugin) and written in the Chrome trace
+ * event format, which can be opened with ui.perfetto.dev or chrome://tracing.
+ */
+namespace trace
+{
+/** Whether a trace is currently being recorded. */
+extern std::atomic<bool> recording;
+
+/**
+ * Start recording a trace, which will be written to the file at @path when the recording is stopped.
+ * @return false if a trace is already being recorded.
+ */
+bool start(const std::string& path);
+
+/**
+ * Stop recording the trace and write it to the file given in start(). The file is written on a worker
+ * thread.
+ *
+ * @return The number of recorded events, or -1 if no trace was being recorded.
+ */
+int64_t stop();
+
+/** @return The current time in microseconds, on the clock used for trace events. */
+int64_t now_us();
+
+/**
+ * Record an event with the given duration.
+ * @param name The name of the event. It is not copied, so it should be a string literal.
+ */
+void record(const char *name, int64_t start_us, int64_t duration_us);
+
+/** Records the time spent in a scope, see WF_TRACE_SCOPE. */
+class scope_t
+{
+  public:
+    scope_t(const char *name) : name(name),
+        start_us(recording.load(std::memory_order_relaxed) ? now_us() : -1)
+    {}
+
+    ~scope_t()
+    {
+        if (start_us >= 0)
+        {
+            record(name, start_us, now_us() - start_us);
+        }
+    }
+
+    scope_t(const scope_t&) = delete;
+    scope_t& operator =(const scope_t&) = delete;
+
+  private:
+    const char *name;
+    int64_t start_us;
+};
+}
+}
+
+#ifdef WF_ENABLE_TRACING
+    #define WF_TRACE_CONCAT_IMPL(a, b) a ## b
+    #define WF_TRACE_CONCAT(a, b) WF_TRACE_CONCAT_IMPL(a, b)
+/** Record the time spent in the enclosing scope as a trace event with the given name. */
+    #define WF_TRACE_SCOPE(name) wf::trace::scope_t WF_TRACE_CONCAT(wf_trace_scope_, __LINE__){name}
+#else
+    #define WF_TRACE_SCOPE(name)
+#endif
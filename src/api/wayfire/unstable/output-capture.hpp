@@ -0,0 +1,26 @@
+#pragma once
+
+#include <wayfire/object.hpp>
+#include <cstdint>
+
+namespace wf
+{
+/**
+ * Statistics about the ext-image-copy-capture sessions capturing an output.
+ *
+ * Core captures outputs by copying only the damaged parts of each frame into the client buffers (when
+ * both the output buffer and the client buffer are accessible from the CPU, e.g. with the pixman renderer
+ * and shm client buffers), and does not send frames at all while the output is not damaged.
+ *
+ * Stored as custom data on the output once it has been captured for the first time.
+ */
+struct output_capture_stats_t : public wf::custom_data_t
+{
+    /** Number of frames delivered to capturing clients. */
+    uint64_t frames = 0;
+    /** Number of frames which had to be copied completely, through the renderer. */
+    uint64_t full_copies = 0;
+    /** Total number of bytes copied into client buffers. */
+    uint64_t bytes_copied = 0;
+};
+}
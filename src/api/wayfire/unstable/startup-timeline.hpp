@@ -0,0 +1,73 @@
+#pragma once
+
+#include <wayfire/object.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+/**
+ * The timeline of the compositor startup: how long creating the backend, loading the configuration,
+ * initializing core, and opening and initializing each plugin took, up to the first frame committed on any
+ * output.
+ *
+ * Stored as custom data on core. Once the first frame has been committed, the timeline is printed to the
+ * log and no further phases are recorded, so reloading plugins at runtime does not show up here.
+ */
+struct startup_timeline_t : public wf::custom_data_t
+{
+    struct phase_t
+    {
+        std::string name;
+        /** Start of the phase, in microseconds since core was allocated. */
+        int64_t start_us;
+        int64_t duration_us;
+    };
+
+    std::vector<phase_t> phases;
+    bool finished = false;
+
+    /** @return The number of microseconds since core was allocated. */
+    int64_t now_us() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - origin).count();
+    }
+
+    /** Record a phase which started at @start_us and ends now. */
+    void add_phase(std::string name, int64_t start_us)
+    {
+        if (!finished)
+        {
+            phases.push_back({std::move(name), start_us, now_us() - start_us});
+        }
+    }
+
+  private:
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+};
+
+/** Records the time between its construction and its destruction as a phase of the startup timeline. */
+class startup_phase_timer_t
+{
+  public:
+    startup_phase_timer_t(startup_timeline_t *timeline, std::string name) :
+        timeline(timeline), name(std::move(name)), start_us(timeline->now_us())
+    {}
+
+    ~startup_phase_timer_t()
+    {
+        timeline->add_phase(std::move(name), start_us);
+    }
+
+    startup_phase_timer_t(const startup_phase_timer_t&) = delete;
+    startup_phase_timer_t& operator =(const startup_phase_timer_t&) = delete;
+
+  private:
+    startup_timeline_t *timeline;
+    std::string name;
+    int64_t start_us;
+};
+}
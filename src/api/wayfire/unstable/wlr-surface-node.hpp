@@ -6,6 +6,9 @@
 #include <wayfire/scene.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/output-layout.hpp>
+#include <wayfire/render-manager.hpp>
+#include <array>
+#include <map>
 
 namespace wf
 {
@@ -41,6 +44,21 @@ struct surface_state_t
     surface_state_t& operator =(surface_state_t&& other);
 };
 
+/**
+ * Statistics about the buffers a surface commits and how they are presented.
+ */
+struct surface_presentation_stats_t
+{
+    /** Number of commits with a new buffer. */
+    uint64_t commits = 0;
+    /** Number of buffers which were rendered or scanned out on at least one output. */
+    uint64_t presented = 0;
+    /** Number of buffers which were replaced by a newer one before being shown, while being visible. */
+    uint64_t dropped = 0;
+    /** Sum of the time between the commit of each presented buffer and its first presentation, in usec. */
+    uint64_t total_latency_us = 0;
+};
+
 /**
  * An implementation of node_t for wlr_surfaces.
  *
@@ -56,6 +74,7 @@ class wlr_surface_node_t : public node_t, public zero_copy_texturable_node_t
      *   or it should wait until it is manually applied.
      */
     wlr_surface_node_t(wlr_surface *surface, bool autocommit);
+    ~wlr_surface_node_t();
 
     std::optional<input_node_t> find_node_at(const wf::pointf_t& at) override;
 
@@ -73,6 +92,12 @@ class wlr_surface_node_t : public node_t, public zero_copy_texturable_node_t
     void apply_current_surface_state();
     void send_frame_done(bool delay_until_vblank);
 
+    /**
+     * @return The cadence at which the surface commits new buffers, if it has been stable recently.
+     */
+    std::optional<wf::commit_cadence_t> get_commit_cadence() const;
+    const surface_presentation_stats_t& get_presentation_stats() const;
+
   private:
     std::unique_ptr<pointer_interaction_t> ptr_interaction;
     std::unique_ptr<touch_interaction_t> tch_interaction;
@@ -88,6 +113,30 @@ class wlr_surface_node_t : public node_t, public zero_copy_texturable_node_t
     void update_pending_outputs();
     wf::wl_idle_call idle_update_outputs;
 
+    // Surfaces which are not visible anywhere receive frame callbacks only at a low rate, which is the same
+    // for all surfaces, see hidden_frame_rate_t.
+    struct hidden_frame_rate_t;
+    std::map<wf::output_t*, int> visible_instances;
+    wf::wl_timer<true> hidden_frame_timer;
+    bool frame_throttled = false;
+    void set_instance_visible(wf::output_t *output, bool visible);
+    void update_frame_throttling();
+    void stop_frame_throttling();
+
+    // Commit cadence detection: intervals between the last few buffer commits, in a ring buffer.
+    static constexpr size_t CADENCE_SAMPLES = 16;
+    std::array<int64_t, CADENCE_SAMPLES> commit_intervals_us;
+    size_t num_commit_intervals = 0;
+    int64_t last_buffer_commit_us = -1;
+    int pending_buffer_commits    = 0;
+    void record_buffer_commit();
+    void update_cadence_hints(std::optional<wf::commit_cadence_t> cadence);
+
+    surface_presentation_stats_t presentation_stats;
+    int64_t current_buffer_commit_us = -1;
+    bool current_buffer_presented    = true;
+    void mark_presented();
+
     wf::wl_listener_wrapper on_surface_destroyed;
     wf::wl_listener_wrapper on_surface_commit;
 
@@ -212,6 +212,7 @@ class transformer_render_instance_t : public render_instance_t
     direct_scanout try_scanout(wf::output_t *output) override
     {
         // By default, disable direct scanout
+        report_scanout_blocker(output, scanout_blocker_t::TRANSFORMED, self.get());
         return direct_scanout::OCCLUSION;
     }
 
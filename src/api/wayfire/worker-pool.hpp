@@ -0,0 +1,64 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+namespace wf
+{
+/**
+ * A small pool of background threads for work which would otherwise stall the compositor thread, for
+ * example rasterizing text or decoding images.
+ *
+ * Jobs are executed on one of the worker threads. Their completion callbacks are always dispatched on the
+ * main thread, from the compositor event loop, so they may freely use the rest of Wayfire's API (e.g. to
+ * upload the result to a texture or damage a node).
+ *
+ * A job must not touch compositor state: it should only work on data which it owns (typically captured by
+ * value). Completion callbacks may run long after the job was submitted, so they should capture shared or
+ * weak pointers to their state instead of raw pointers.
+ *
+ * The pool is available as wf::get_core().workers.
+ */
+class worker_pool_t
+{
+  public:
+    using job_t = std::function<void ()>;
+
+    /**
+     * Create a new worker pool. Threads are spawned lazily, when the first job is submitted.
+     *
+     * @param max_threads The maximal number of worker threads. If zero, a number based on the available
+     *   hardware concurrency is used.
+     */
+    worker_pool_t(int max_threads = 0);
+
+    /** Stops all threads after their current job. Queued jobs and pending completions are discarded. */
+    ~worker_pool_t();
+
+    worker_pool_t(const worker_pool_t&) = delete;
+    worker_pool_t(worker_pool_t&&) = delete;
+    worker_pool_t& operator =(const worker_pool_t&) = delete;
+    worker_pool_t& operator =(worker_pool_t&&) = delete;
+
+    /**
+     * Queue a job for execution on a worker thread.
+     *
+     * @param job The work to be done in the background.
+     * @param on_done An optional callback invoked on the main thread after @job has finished.
+     */
+    void submit(job_t job, job_t on_done = {});
+
+    /**
+     * Block until all queued jobs have finished, then run their completion callbacks.
+     * Needed for example before unloading a plugin whose code the queued jobs may reference.
+     */
+    void flush();
+
+    /** @return The maximal number of worker threads of the pool. */
+    int get_max_threads() const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> priv;
+};
+}
@@ -0,0 +1,76 @@
+#include "commit-timing.hpp"
+
+namespace wf
+{
+wlr_output *choose_commit_timing_output(const std::vector<wlr_output*>& outputs)
+{
+    wlr_output *best = nullptr;
+    for (auto output : outputs)
+    {
+        if (!best || (output->refresh > best->refresh))
+        {
+            best = output;
+        }
+    }
+
+    return best;
+}
+
+commit_timing_manager_t::commit_timing_manager_t(wl_display *display)
+{
+    manager = wlr_commit_timing_manager_v1_create(display, 1);
+    on_new_timer.set_callback([this] (void *data)
+    {
+        auto ev    = static_cast<wlr_commit_timing_manager_v1_new_timer_event*>(data);
+        auto timer = ev->timer;
+
+        auto& entry = timers[timer->surface];
+        entry = std::make_unique<timer_entry_t>();
+        entry->timer = timer;
+        entry->on_destroy.set_callback([this, surface = timer->surface] (void*)
+        {
+            auto it = timers.find(surface);
+            it->second->on_destroy.disconnect();
+            destroyed_entries.push_back(std::move(it->second));
+            timers.erase(it);
+            free_destroyed_entries.run_once([this] ()
+            {
+                destroyed_entries.clear();
+            });
+        });
+        entry->on_destroy.connect(&timer->events.destroy);
+
+        // The surface may already be visible when the client creates the timer.
+        update_output(timer->surface);
+    });
+    on_new_timer.connect(&manager->events.new_timer);
+}
+
+commit_timing_manager_t::~commit_timing_manager_t()
+{
+    on_new_timer.disconnect();
+    timers.clear();
+}
+
+void commit_timing_manager_t::update_output(wlr_surface *surface)
+{
+    auto it = timers.find(surface);
+    if (it == timers.end())
+    {
+        return;
+    }
+
+    std::vector<wlr_output*> outputs;
+    wlr_surface_output *surface_output;
+    wl_list_for_each(surface_output, &surface->current_outputs, link)
+    {
+        outputs.push_back(surface_output->output);
+    }
+
+    // Keep the last output while the surface is not shown anywhere, its commits are not presented then.
+    if (auto output = choose_commit_timing_output(outputs))
+    {
+        wlr_commit_timing_v1_set_output(it->second->timer, output);
+    }
+}
+}
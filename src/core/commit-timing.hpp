@@ -0,0 +1,63 @@
+#pragma once
+
+#include <wayfire/nonstd/wlroots-full.hpp>
+#include <wayfire/util.hpp>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace wf
+{
+/**
+ * Choose the output whose refresh cycle times the commits of a surface shown on the given outputs: the one
+ * with the highest refresh rate, so that a commit released for it is not late on any of the others.
+ *
+ * @return The output, or nullptr if @outputs is empty.
+ */
+wlr_output *choose_commit_timing_output(const std::vector<wlr_output*>& outputs);
+
+/**
+ * Implements commit-timing-v1 together with wlroots.
+ *
+ * wlroots holds back commits which have a target presentation time, and releases each of them at the start
+ * of the refresh cycle of the surface's timing output which ends closest to the target time. The released
+ * commit then schedules a repaint of the output like any other commit, so that it is presented at the
+ * target time. Wayfire's part is to assign that output to each timer, and to keep it up to date when the
+ * surface moves between outputs, see update_output().
+ */
+class commit_timing_manager_t
+{
+  public:
+    commit_timing_manager_t(wl_display *display);
+    ~commit_timing_manager_t();
+
+    /**
+     * Update the timing output of the surface's timer (if it has one) after the surface has entered or left
+     * an output.
+     */
+    void update_output(wlr_surface *surface);
+
+    wlr_commit_timing_manager_v1 *get_manager() const
+    {
+        return manager;
+    }
+
+  private:
+    struct timer_entry_t
+    {
+        wlr_commit_timing_v1 *timer;
+        wf::wl_listener_wrapper on_destroy;
+    };
+
+    wlr_commit_timing_manager_v1 *manager;
+    wf::wl_listener_wrapper on_new_timer;
+
+    // There is at most one timer per surface.
+    std::map<wlr_surface*, std::unique_ptr<timer_entry_t>> timers;
+
+    // Entries of destroyed timers. Their listener is still running when the timer is destroyed, so they are
+    // freed on idle.
+    std::vector<std::unique_ptr<timer_entry_t>> destroyed_entries;
+    wf::wl_idle_call free_destroyed_entries;
+};
+}
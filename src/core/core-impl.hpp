@@ -14,6 +14,8 @@ namespace wf
 class seat_t;
 class input_manager_t;
 class input_method_relay;
+class output_capture_manager_t;
+class commit_timing_manager_t;
 class compositor_core_impl_t : public compositor_core_t
 {
   public:
@@ -23,6 +25,8 @@ class compositor_core_impl_t : public compositor_core_t
 
     std::unique_ptr<wf::input_manager_t> input;
     std::unique_ptr<input_method_relay> im_relay;
+    std::unique_ptr<output_capture_manager_t> output_capture;
+    std::unique_ptr<commit_timing_manager_t> commit_timing;
     std::unique_ptr<plugin_manager_t> plugin_mgr;
 
     /**
@@ -94,7 +98,6 @@ class compositor_core_impl_t : public compositor_core_t
     compositor_state_t state = compositor_state_t::UNKNOWN;
     struct rlimit user_maxfiles;
     void increase_nofile_limit();
-    void restore_nofile_limit();
 
   private:
     wf::option_wrapper_t<bool> discard_command_output;
@@ -11,6 +11,7 @@
 #include "wayfire/txn/transaction-manager.hpp"
 #include "wayfire/bindings-repository.hpp"
 #include "wayfire/util.hpp"
+#include "wayfire/worker-pool.hpp"
 #include <memory>
 #include "wayfire/config-backend.hpp" // IWYU pragma: keep
 
@@ -33,10 +34,14 @@
 #include <wayfire/nonstd/wlroots-full.hpp>
 
 #include "wayfire/unstable/wlr-surface-controller.hpp"
+#include "wayfire/unstable/startup-timeline.hpp"
 #include "wayfire/scene-input.hpp"
 #include "opengl-priv.hpp"
 #include "seat/input-manager.hpp"
 #include "seat/input-method-relay.hpp"
+#include "output-capture.hpp"
+#include "commit-timing.hpp"
+#include "spawn.hpp"
 #include "seat/touch.hpp"
 #include "seat/pointer.hpp"
 #include "seat/cursor.hpp"
@@ -101,6 +106,7 @@ void wf::compositor_core_impl_t::init()
     this->scene_root = std::make_shared<scene::root_node_t>();
     this->tx_manager = std::make_unique<txn::transaction_manager_t>();
     this->default_wm = std::make_unique<wf::window_manager_t>();
+    this->workers    = std::make_unique<wf::worker_pool_t>();
 
     wlr_renderer_init_wl_display(renderer, display);
 
@@ -146,7 +152,8 @@ void wf::compositor_core_impl_t::init()
     protocols.screencopy = wlr_screencopy_manager_v1_create(display);
     protocols.foreign_toplevel_list = wlr_ext_foreign_toplevel_list_v1_create(display, 1);
     protocols.image_copy_capture    = wlr_ext_image_copy_capture_manager_v1_create(display, 1);
-    protocols.image_capture_source  = wlr_ext_output_image_capture_source_manager_v1_create(display, 1);
+    // Output capture sources are implemented by Wayfire itself, to copy only the damaged parts of frames.
+    output_capture = std::make_unique<output_capture_manager_t>(display);
     protocols.gamma_v1 = wlr_gamma_control_manager_v1_create(display);
     protocols.export_dmabuf  = wlr_export_dmabuf_manager_v1_create(display);
     protocols.output_manager = wlr_xdg_output_manager_v1_create(display,
@@ -234,6 +241,15 @@ void wf::compositor_core_impl_t::init()
     protocols.presentation = wlr_presentation_create(display, backend, 2);
     protocols.viewporter   = wlr_viewporter_create(display);
 
+    // Both protocols hold back surface commits: fifo-v1 until the outputs the surface is on have refreshed,
+    // commit-timing-v1 until the refresh cycle in which the requested presentation time falls, see
+    // commit_timing_manager_t. Released commits reach the surface nodes as regular commits, which schedule
+    // a repaint and feed the cadence tracking used to align repaints, see render_manager::set_commit_cadence.
+    protocols.fifo = wlr_fifo_manager_v1_create(display, 1);
+    commit_timing  = std::make_unique<commit_timing_manager_t>(display);
+    protocols.commit_timing = commit_timing->get_manager();
+    protocols.content_type  = wlr_content_type_manager_v1_create(display, 1);
+
     protocols.foreign_registry = wlr_xdg_foreign_registry_create(display);
     protocols.foreign_v1 = wlr_xdg_foreign_v1_create(display,
         protocols.foreign_registry);
@@ -273,14 +289,6 @@ void wf::compositor_core_impl_t::increase_nofile_limit()
     }
 }
 
-void wf::compositor_core_impl_t::restore_nofile_limit()
-{
-    if (setrlimit(RLIMIT_NOFILE, &user_maxfiles) != 0)
-    {
-        LOGE("Failed to setrlimit(RLIMIT_NOFILE), could not restore maximum open file descriptors.");
-    }
-}
-
 void wf::compositor_core_impl_t::post_init()
 {
     discard_command_output.load_option("workarounds/discard_command_output");
@@ -288,7 +296,11 @@ void wf::compositor_core_impl_t::post_init()
     core_backend_started_signal backend_started_ev;
     this->emit(&backend_started_ev);
     this->state = compositor_state_t::START_PLUGINS;
-    plugin_mgr  = std::make_unique<wf::plugin_manager_t>();
+    {
+        startup_phase_timer_t phase{get_data_safe<startup_timeline_t>(), "plugins"};
+        plugin_mgr = std::make_unique<wf::plugin_manager_t>();
+    }
+
     this->bindings->reparse_extensions();
 
     this->state = compositor_state_t::RUNNING;
@@ -346,6 +358,7 @@ void wf::compositor_core_impl_t::fini()
 
     LOGI("Unloading plugins...");
     plugin_mgr.reset();
+    workers.reset();
     _clear_data();
 
     // wl_display_destroy_clients().
@@ -359,6 +372,8 @@ void wf::compositor_core_impl_t::fini()
 
     // General core stuff
     im_relay.reset();
+    output_capture.reset();
+    commit_timing.reset();
     seat.reset();
     input.reset();
     output_layout.reset();
@@ -510,82 +525,22 @@ std::vector<wayfire_view> wf::compositor_core_t::get_all_views()
  */
 pid_t wf::compositor_core_impl_t::run(std::string command)
 {
-    static constexpr size_t READ_END  = 0;
-    static constexpr size_t WRITE_END = 1;
-
-    int pipe_fd[2];
-    int ret = pipe2(pipe_fd, O_CLOEXEC);
-    if (ret == -1)
-    {
-        LOGE("wf::compositor_core_impl_t::run: failed to create pipe2: ", strerror(errno));
-        return 0;
-    }
-
-    /* The following is a "hack" for disowning the child processes,
-     * otherwise they will simply stay as zombie processes */
-    pid_t pid = fork();
-    if (!pid)
+    static const std::string java_var = "_JAVA_AWT_WM_NONREPARENTING=";
+    static const std::string display_var = "WAYLAND_DISPLAY=";
+    std::vector<std::string> env;
+    for (char **var = environ; *var; var++)
     {
-        restore_nofile_limit();
-        pid = fork();
-        if (!pid)
+        std::string_view entry = *var;
+        if ((entry.compare(0, java_var.size(), java_var) != 0) &&
+            (entry.compare(0, display_var.size(), display_var) != 0))
         {
-            close(pipe_fd[READ_END]);
-            close(pipe_fd[WRITE_END]);
-
-            setenv("_JAVA_AWT_WM_NONREPARENTING", "1", 1);
-            setenv("WAYLAND_DISPLAY", wayland_display.c_str(), 1);
-
-            if (discard_command_output)
-            {
-                int dev_null = open("/dev/null", O_WRONLY);
-                dup2(dev_null, 1);
-                dup2(dev_null, 2);
-                close(dev_null);
-            }
-
-            _exit(execl("/bin/sh", "/bin/sh", "-c", command.c_str(), NULL));
-        } else
-        {
-            close(pipe_fd[READ_END]);
-            int ret = write(pipe_fd[WRITE_END], (void*)(&pid), sizeof(pid));
-            close(pipe_fd[WRITE_END]);
-            _exit(ret != sizeof(pid) ? 1 : 0);
+            env.emplace_back(entry);
         }
-    } else
-    {
-        close(pipe_fd[WRITE_END]);
-
-        int status;
-        waitpid(pid, &status, 0);
-
-        // Return 0 if the child process didn't run or didn't exit normally, or returns a non-zero return
-        // value.
-        pid_t child_pid{};
-        if (WIFEXITED(status) && (WEXITSTATUS(status) == 0))
-        {
-            int ret = read(pipe_fd[READ_END], &child_pid, sizeof(child_pid));
-            if (ret != sizeof(child_pid))
-            {
-                // This is consider to be an error (even though theoretically a partial read would require an
-                // attempt to continue).
-                child_pid = 0;
-                if (ret == -1)
-                {
-                    LOGE("wf::compositor_core_impl_t::run(\"", command,
-                        "\"): failed to read PID from pipe end: ", strerror(errno));
-                } else
-                {
-                    LOGE("wf::compositor_core_impl_t::run(\"", command,
-                        "\"): short read of PID from pipe end, got ", std::to_string(ret), " bytes");
-                }
-            }
-        }
-
-        close(pipe_fd[READ_END]);
-
-        return child_pid;
     }
+
+    env.push_back(java_var + "1");
+    env.push_back(display_var + wayland_display);
+    return spawn_command(command, env, user_maxfiles.rlim_cur, discard_command_output);
 }
 
 void wf::start_move_view_to_wset(wayfire_toplevel_view v, std::shared_ptr<wf::workspace_set_t> new_wset)
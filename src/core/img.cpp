@@ -4,6 +4,7 @@
 #include "wayfire/img.hpp"
 #include "wayfire/opengl.hpp"
 #include "wayfire/core.hpp"
+#include "wayfire/worker-pool.hpp"
 
 #include <config.h>
 
@@ -13,27 +14,36 @@
     #include <jerror.h>
 #endif
 
+#include <setjmp.h>
 #include <stdint.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <string.h>
 #include <cstdio>
 #include <unordered_map>
+#include <algorithm>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #define TEXTURE_LOAD_ERROR 0
 
 namespace image_io
 {
-using Loader = std::function<bool (const char*, GLuint)>;
-using Writer = std::function<void (const char*name, uint8_t*pixels, unsigned long,
-    unsigned long, bool)>;
+using Decoder = std::function<bool (const uint8_t *data, size_t size, decoded_image_t& out)>;
+using Writer  = std::function<bool (const char *name, const uint8_t *pixels, int w, int h,
+    bool invert, int compression_level)>;
 namespace
 {
-std::unordered_map<std::string, Loader> loaders;
+std::unordered_map<std::string, Decoder> decoders;
 std::unordered_map<std::string, Writer> writers;
+/* Files being decoded in the background and the callbacks waiting for them. Main thread only. */
+std::map<std::string, std::vector<std::function<void(decoded_image_ptr)>>> pending_loads;
 }
 
-bool load_data_as_cubemap(unsigned char *data, int width, int height, int channels)
+bool load_data_as_cubemap(const unsigned char *data, int width, int height, int channels)
 {
     width  /= 4;
     height /= 3;
@@ -121,279 +131,358 @@ bool load_data_as_cubemap(unsigned char *data, int width, int height, int channe
 }
 
 #ifdef BUILD_WITH_IMAGEIO
-/* All backend functions are taken from the internet.
- * If you want to be credited, contact me */
-bool texture_from_png(const char *filename, GLuint target)
+bool decode_png(const uint8_t *data, size_t size, decoded_image_t& out)
 {
-    FILE *fp = fopen(filename, "rb");
-    int width, height;
-    png_byte color_type;
-    png_byte bit_depth;
-    png_bytep *row_pointers;
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&image, data, size))
+    {
+        LOGE("failed to read PNG header: ", image.message);
+        return false;
+    }
 
-    png_structp png =
-        png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (!png)
+    // libpng converts all color types and bit depths to 8-bit RGBA
+    image.format = PNG_FORMAT_RGBA;
+    out.width    = image.width;
+    out.height   = image.height;
+    out.channels = 4;
+    out.pixels.resize(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, NULL, out.pixels.data(), 0, NULL))
     {
-        fclose(fp);
+        LOGE("failed to decode PNG: ", image.message);
+        png_image_free(&image);
         return false;
     }
 
-    png_infop infos = png_create_info_struct(png);
-    if (!infos)
+    return true;
+}
+
+bool texture_to_png(const char *name, const uint8_t *pixels, int w, int h, bool invert,
+    int compression_level)
+{
+    FILE *fp = fopen(name, "wb");
+    if (!fp)
     {
+        LOGE("failed to open ", name, " for writing");
+        return false;
+    }
+
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr,
+        nullptr, nullptr);
+    png_infop infot = png ? png_create_info_struct(png) : nullptr;
+    if (!infot)
+    {
+        png_destroy_write_struct(&png, nullptr);
         fclose(fp);
         return false;
     }
 
     if (setjmp(png_jmpbuf(png)))
     {
+        LOGE("failed to encode ", name);
+        png_destroy_write_struct(&png, &infot);
         fclose(fp);
         return false;
     }
 
     png_init_io(png, fp);
-    png_read_info(png, infos);
-
-    width  = png_get_image_width(png, infos);
-    height = png_get_image_height(png, infos);
-    color_type = png_get_color_type(png, infos);
-    bit_depth  = png_get_bit_depth(png, infos);
-
-    if (bit_depth == 16)
+    if (compression_level >= 0)
     {
-        png_set_strip_16(png);
+        png_set_compression_level(png, compression_level);
+        if (compression_level <= 1)
+        {
+            /* Row filters cost more time than they save when (almost) not compressing */
+            png_set_filter(png, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+        }
     }
 
-    if (color_type == PNG_COLOR_TYPE_PALETTE)
-    {
-        png_set_palette_to_rgb(png);
-    }
+    png_set_IHDR(png, infot, w, h, 8 /* depth */, PNG_COLOR_TYPE_RGBA,
+        PNG_INTERLACE_NONE,
+        PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+    png_write_info(png, infot);
 
-    // PNG_COLOR_TYPE_GRAY_ALPHA is always 8 or 16bit depth.
-    if ((color_type == PNG_COLOR_TYPE_GRAY) && (bit_depth < 8))
+    /* Encode row by row, so that no row pointer array for the whole image is needed */
+    for (int i = 0; i < h; ++i)
     {
-        png_set_expand_gray_1_2_4_to_8(png);
+        const int row = invert ? (h - i - 1) : i;
+        png_write_row(png, (png_const_bytep)(pixels + (size_t)row * w * 4));
     }
 
-    if (png_get_valid(png, infos, PNG_INFO_tRNS))
-    {
-        png_set_tRNS_to_alpha(png);
-    }
+    png_write_end(png, infot);
+    png_destroy_write_struct(&png, &infot);
+    return fclose(fp) == 0;
+}
+
+/* libjpeg's default error handler calls exit(), jump back to decode_jpeg() instead. */
+struct jpeg_error_handler_t
+{
+    struct jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
 
-    // These color_type don't have an alpha channel then fill it with 0xff.
-    if ((color_type == PNG_COLOR_TYPE_RGB) ||
-        (color_type == PNG_COLOR_TYPE_GRAY) ||
-        (color_type == PNG_COLOR_TYPE_PALETTE))
+static void handle_jpeg_error(j_common_ptr info)
+{
+    char message[JMSG_LENGTH_MAX];
+    info->err->format_message(info, message);
+    LOGE("failed to decode JPEG: ", message);
+    longjmp(((jpeg_error_handler_t*)info->err)->jump, 1);
+}
+
+bool decode_jpeg(const uint8_t *data, size_t size, decoded_image_t& out)
+{
+    struct jpeg_decompress_struct infot;
+    jpeg_error_handler_t err;
+
+    infot.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = handle_jpeg_error;
+    if (setjmp(err.jump))
     {
-        png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+        jpeg_destroy_decompress(&infot);
+        return false;
     }
 
-    if ((color_type == PNG_COLOR_TYPE_GRAY) ||
-        (color_type == PNG_COLOR_TYPE_GRAY_ALPHA))
+    jpeg_create_decompress(&infot);
+    jpeg_mem_src(&infot, data, size);
+    jpeg_read_header(&infot, TRUE);
+    infot.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&infot);
+
+    out.width    = infot.output_width;
+    out.height   = infot.output_height;
+    out.channels = 3;
+    out.pixels.resize((size_t)out.width * out.height * 3);
+    while (infot.output_scanline < infot.output_height)
     {
-        png_set_gray_to_rgb(png);
+        unsigned char *rowptr = out.pixels.data() + (size_t)3 * out.width * infot.output_scanline;
+        jpeg_read_scanlines(&infot, &rowptr, 1);
     }
 
-    png_read_update_info(png, infos);
+    jpeg_finish_decompress(&infot);
+    jpeg_destroy_decompress(&infot);
+    return true;
+}
 
-    row_pointers = new png_bytep[height];
-    png_byte *data = new png_byte[height * png_get_rowbytes(png, infos)];
+#endif
 
-    for (int i = 0; i < height; i++)
+/*
+ * Decoded images, keyed by the path, size and modification time of the file, so that a file which has not
+ * changed is not even read again. Accessed from the worker threads too.
+ *
+ * The cache does not keep images alive by itself: an image is shared while someone still holds it (for
+ * example, several outputs loading the same background), and freed as soon as the last user has uploaded
+ * and dropped it.
+ */
+struct image_cache_t
+{
+    struct key_t
     {
-        row_pointers[i] = data + i * png_get_rowbytes(png, infos);
-    }
+        std::string path;
+        off_t size;
+        int64_t mtime_ns;
 
-    png_read_image(png, row_pointers);
+        bool operator ==(const key_t& other) const
+        {
+            return (path == other.path) && (size == other.size) && (mtime_ns == other.mtime_ns);
+        }
+    };
 
-    if (target == GL_TEXTURE_CUBE_MAP)
+    std::mutex mutex;
+    std::vector<std::pair<key_t, std::weak_ptr<const decoded_image_t>>> images;
+
+    decoded_image_ptr find(const key_t& key)
     {
-        if (!load_data_as_cubemap(data, width, height,
-            png_get_channels(png, infos)))
+        std::lock_guard lock{mutex};
+        remove_expired();
+        for (auto& [image_key, image] : images)
         {
-            png_destroy_read_struct(&png, &infos, NULL);
-            delete[] row_pointers;
-            delete[] data;
-            fclose(fp);
-            return false;
+            if (image_key == key)
+            {
+                return image.lock();
+            }
         }
-    } else if (target == GL_TEXTURE_2D)
-    {
-        GL_CALL(glTexImage2D(target, 0, GL_RGBA, width, height, 0,
-            GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)data));
+
+        return nullptr;
     }
 
-    png_destroy_read_struct(&png, &infos, NULL);
-    delete[] row_pointers;
-    delete[] data;
+    void insert(const key_t& key, decoded_image_ptr image)
+    {
+        std::lock_guard lock{mutex};
+        remove_expired();
+        images.emplace_back(key, image);
+    }
 
-    fclose(fp);
+  private:
+    void remove_expired()
+    {
+        images.erase(std::remove_if(images.begin(), images.end(),
+            [] (const auto& entry) { return entry.second.expired(); }), images.end());
+    }
+};
 
-    return true;
+namespace
+{
+image_cache_t image_cache;
 }
 
-void texture_to_png(const char *name, uint8_t *pixels, int w, int h, bool invert)
+/* Read the whole file, reusing the buffer between calls from the same thread. */
+static bool read_file(const std::string& name, std::vector<uint8_t>& contents)
 {
-    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr,
-        nullptr, nullptr);
-    if (!png)
+    std::FILE *file = fopen(name.c_str(), "rb");
+    if (!file)
     {
-        return;
+        return false;
     }
 
-    png_infop infot = png_create_info_struct(png);
-    if (!infot)
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if (size < 0)
     {
-        png_destroy_write_struct(&png, &infot);
-
-        return;
+        fclose(file);
+        return false;
     }
 
-    FILE *fp = fopen(name, "wb");
-    if (!fp)
+    contents.resize(size);
+    bool ok = (std::fread(contents.data(), 1, size, file) == (size_t)size);
+    fclose(file);
+    return ok;
+}
+
+/* Find the decoder for the file, or nullptr (with an error message) if it is not supported. */
+static const Decoder *find_decoder(const std::string& name)
+{
+    if (access(name.c_str(), F_OK) == -1)
     {
-        png_destroy_write_struct(&png, &infot);
+        if (!name.empty())
+        {
+            LOGE("load_from_file() cannot access ", name);
+        }
 
-        return;
+        return nullptr;
     }
 
-    png_init_io(png, fp);
-    png_set_IHDR(png, infot, w, h, 8 /* depth */, PNG_COLOR_TYPE_RGBA,
-        PNG_INTERLACE_NONE,
-        PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
-    png_colorp palette =
-        (png_colorp)png_malloc(png, PNG_MAX_PALETTE_LENGTH * sizeof(png_color));
-    if (!palette)
+    int len = name.length();
+    if ((len < 4) || (name[len - 4] != '.'))
     {
-        fclose(fp);
-        png_destroy_write_struct(&png, &infot);
+        LOGE(
+            "load_from_file() called with file without extension or with invalid extension!");
 
-        return;
+        return nullptr;
     }
 
-    png_set_PLTE(png, infot, palette, PNG_MAX_PALETTE_LENGTH);
-    png_write_info(png, infot);
-    png_set_packing(png);
-
-    png_bytepp rows = (png_bytepp)png_malloc(png, h * sizeof(png_bytep));
-    for (int i = 0; i < h; ++i)
+    auto ext = name.substr(len - 3, 3);
+    for (int i = 0; i < 3; i++)
     {
-        if (invert)
-        {
-            rows[i] = (png_bytep)(pixels + (h - i - 1) * w * 4);
-        } else
-        {
-            rows[i] = (png_bytep)(pixels + i * w * 4);
-        }
+        ext[i] = std::tolower(ext[i]);
     }
 
-    png_write_image(png, rows);
-    png_write_end(png, infot);
-    png_free(png, palette);
-    png_destroy_write_struct(&png, &infot);
+    auto it = decoders.find(ext);
+    if (it == decoders.end())
+    {
+        LOGE("load_from_file() called with unsupported extension ", ext);
+        return nullptr;
+    }
 
-    fclose(fp);
-    png_free(png, rows);
+    return &it->second;
 }
 
-bool texture_from_jpeg(const char *FileName, GLuint target)
+/* Decode the file with the given decoder, or get it from the cache. Safe to call from any thread. */
+static decoded_image_ptr decode_file(const std::string& name, const Decoder& decoder)
 {
-    unsigned long data_size;
-    unsigned char *rowptr[1];
-    unsigned char *jdata;
-    struct jpeg_decompress_struct infot;
-    struct jpeg_error_mgr err;
-
-    std::FILE *file = fopen(FileName, "rb");
-    infot.err = jpeg_std_error(&err);
-    jpeg_create_decompress(&infot);
-
-    if (!file)
+    struct stat file_stat;
+    if (stat(name.c_str(), &file_stat) != 0)
     {
-        LOGE("failed to read JPEG file ", FileName);
-
-        return false;
+        LOGE("failed to stat image file ", name);
+        return nullptr;
     }
 
-    jpeg_stdio_src(&infot, file);
-    jpeg_read_header(&infot, TRUE);
-    jpeg_start_decompress(&infot);
-
-    data_size = infot.output_width * infot.output_height * 3;
+    const image_cache_t::key_t key = {name, file_stat.st_size,
+        (int64_t)file_stat.st_mtim.tv_sec * 1'000'000'000 + file_stat.st_mtim.tv_nsec};
+    if (auto cached = image_cache.find(key))
+    {
+        return cached;
+    }
 
-    jdata = new unsigned char [data_size];
-    while (infot.output_scanline < infot.output_height)
+    thread_local std::vector<uint8_t> contents;
+    if (!read_file(name, contents))
     {
-        rowptr[0] = (unsigned char*)jdata + 3 * infot.output_width *
-            infot.output_scanline;
-        jpeg_read_scanlines(&infot, rowptr, 1);
+        LOGE("failed to read image file ", name);
+        return nullptr;
     }
 
-    jpeg_finish_decompress(&infot);
+    auto image = std::make_shared<decoded_image_t>();
+    if (!decoder(contents.data(), contents.size(), *image))
+    {
+        LOGE("failed to decode image file ", name);
+        return nullptr;
+    }
 
-    GLint width  = infot.output_width;
-    GLint height = infot.output_height;
+    image_cache.insert(key, image);
+    return image;
+}
 
+bool upload_to_texture(const decoded_image_t& image, GLuint target)
+{
+    // RGB rows are not necessarily aligned to 4 bytes
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    bool result = true;
     if (target == GL_TEXTURE_CUBE_MAP)
     {
-        if (!load_data_as_cubemap(jdata, width, height, 3))
-        {
-            fclose(file);
-            delete[] jdata;
-            return false;
-        }
+        result = load_data_as_cubemap(image.pixels.data(), image.width, image.height, image.channels);
     } else if (target == GL_TEXTURE_2D)
     {
-        GL_CALL(glTexImage2D(target, 0, GL_RGB, width, height, 0,
-            GL_RGB, GL_UNSIGNED_BYTE, jdata));
+        auto format = (image.channels == 4 ? GL_RGBA : GL_RGB);
+        GL_CALL(glTexImage2D(target, 0, format, image.width, image.height, 0,
+            format, GL_UNSIGNED_BYTE, image.pixels.data()));
     }
 
-    fclose(file);
-    delete[] jdata;
-
-    return true;
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    return result;
 }
 
-#endif
-
 bool load_from_file(std::string name, GLuint target)
 {
-    if (access(name.c_str(), F_OK) == -1)
+    auto decoder = find_decoder(name);
+    if (!decoder)
     {
-        if (!name.empty())
-        {
-            LOGE(__func__, "() cannot access ", name);
-        }
-
         return false;
     }
 
-    int len = name.length();
-    if ((len < 4) || (name[len - 4] != '.'))
-    {
-        LOGE(
-            "load_from_file() called with file without extension or with invalid extension!");
+    auto image = decode_file(name, *decoder);
+    return image && upload_to_texture(*image, target);
+}
 
-        return false;
+void load_from_file_async(std::string name, std::function<void(decoded_image_ptr)> on_done)
+{
+    auto decoder = find_decoder(name);
+    if (!decoder)
+    {
+        on_done(nullptr);
+        return;
     }
 
-    auto ext = name.substr(len - 3, 3);
-    for (int i = 0; i < 3; i++)
+    // Requests for a file which is already being decoded just wait for the result.
+    const bool in_progress = pending_loads.count(name);
+    pending_loads[name].push_back(std::move(on_done));
+    if (in_progress)
     {
-        ext[i] = std::tolower(ext[i]);
+        return;
     }
 
-    auto it = loaders.find(ext);
-    if (it == loaders.end())
+    auto result = std::make_shared<decoded_image_ptr>();
+    wf::get_core().workers->submit([name, decoder, result] ()
     {
-        LOGE("load_from_file() called with unsupported extension ", ext);
-
-        return false;
-    } else
+        *result = decode_file(name, *decoder);
+    }, [name, result] ()
     {
-        return it->second(name.c_str(), target);
-    }
+        auto callbacks = std::move(pending_loads[name]);
+        pending_loads.erase(name);
+        for (auto& cb : callbacks)
+        {
+            cb(*result);
+        }
+    });
 }
 
 void write_to_file(std::string name, uint8_t *pixels, int w, int h, std::string type,
@@ -406,36 +495,112 @@ void write_to_file(std::string name, uint8_t *pixels, int w, int h, std::string
         LOGE("unsupported image_writer backend");
     } else
     {
-        it->second(name.c_str(), pixels, w, h, invert);
+        it->second(name.c_str(), pixels, w, h, invert, -1);
     }
 }
 
-void write_to_file(std::string name, const wf::render_buffer_t& fb)
+/* Read the pixels of the buffer in RGBA format. Returns false on failure. */
+static bool read_buffer_pixels(const wf::render_buffer_t& fb, std::vector<uint8_t>& pixels,
+    int& width, int& height)
 {
     auto tex = wlr_texture_from_buffer(wf::get_core().renderer, fb.get_buffer());
+    if (!tex)
+    {
+        LOGE("failed to create texture from buffer");
+        return false;
+    }
+
+    width  = tex->width;
+    height = tex->height;
+    pixels.resize((size_t)width * height * 4);
 
-    std::vector<char> buffer(tex->width * tex->height * 4);
     wlr_texture_read_pixels_options opts{};
-    opts.data   = buffer.data();
+    opts.data   = pixels.data();
     opts.format = DRM_FORMAT_ABGR8888;
-    opts.stride = tex->width * 4;
-    if (!wlr_texture_read_pixels(tex, &opts))
+    opts.stride = width * 4;
+    bool ok = wlr_texture_read_pixels(tex, &opts);
+    if (!ok)
     {
         LOGE("failed to read pixels from texture");
-        wlr_texture_destroy(tex);
-        return;
     }
 
-    write_to_file(name, (uint8_t*)buffer.data(), tex->width, tex->height, "png", false);
     wlr_texture_destroy(tex);
+    return ok;
+}
+
+void write_to_file(std::string name, const wf::render_buffer_t& fb)
+{
+    std::vector<uint8_t> buffer;
+    int w, h;
+    if (read_buffer_pixels(fb, buffer, w, h))
+    {
+        write_to_file(name, buffer.data(), w, h, "png", false);
+    }
+}
+
+void write_to_file_async(std::string name, std::vector<uint8_t> pixels, int w, int h,
+    int compression_level, bool invert)
+{
+    auto it = writers.find("png");
+    if ((it == writers.end()) || (pixels.size() < (size_t)w * h * 4))
+    {
+        LOGE(it == writers.end() ? "unsupported image_writer backend" : "pixel buffer too small");
+        write_done_signal ev;
+        ev.name    = std::move(name);
+        ev.success = false;
+        wf::get_core().emit(&ev);
+        return;
+    }
+
+    struct write_job_t
+    {
+        std::string name;
+        std::vector<uint8_t> pixels;
+        bool success = false;
+    };
+
+    auto job = std::make_shared<write_job_t>();
+    job->name   = std::move(name);
+    job->pixels = std::move(pixels);
+
+    Writer writer = it->second;
+    compression_level = std::clamp(compression_level, -1, 9);
+    wf::get_core().workers->submit([job, writer, w, h, invert, compression_level] ()
+    {
+        job->success = writer(job->name.c_str(), job->pixels.data(), w, h, invert, compression_level);
+        /* Release the pixels already on the worker thread */
+        job->pixels = {};
+    }, [job] ()
+    {
+        write_done_signal ev;
+        ev.name    = job->name;
+        ev.success = job->success;
+        wf::get_core().emit(&ev);
+    });
+}
+
+void write_to_file_async(std::string name, const wf::render_buffer_t& buffer, int compression_level)
+{
+    std::vector<uint8_t> pixels;
+    int w = 0, h = 0;
+    if (!read_buffer_pixels(buffer, pixels, w, h))
+    {
+        write_done_signal ev;
+        ev.name    = std::move(name);
+        ev.success = false;
+        wf::get_core().emit(&ev);
+        return;
+    }
+
+    write_to_file_async(std::move(name), std::move(pixels), w, h, compression_level, false);
 }
 
 void init()
 {
     LOGD("init ImageIO");
 #ifdef BUILD_WITH_IMAGEIO
-    loaders["png"] = Loader(texture_from_png);
-    loaders["jpg"] = Loader(texture_from_jpeg);
+    decoders["png"] = Decoder(decode_png);
+    decoders["jpg"] = Decoder(decode_jpeg);
     writers["png"] = Writer(texture_to_png);
 #endif
 }
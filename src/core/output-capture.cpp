@@ -0,0 +1,358 @@
+#include "output-capture.hpp"
+#include <wayfire/core.hpp>
+#include <wayfire/debug.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/output-layout.hpp>
+#include <wayfire/region.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/unstable/output-capture.hpp>
+extern "C"
+{
+#include <wlr/interfaces/wlr_ext_image_capture_source_v1.h>
+}
+#include <drm_fourcc.h>
+
+#include <cstring>
+#include <optional>
+#include <time.h>
+
+namespace wf
+{
+namespace
+{
+/** A frame event of the output source, carrying the buffer which was just committed. */
+struct output_frame_event_t
+{
+    wlr_ext_image_capture_source_v1_frame_event base;
+    wlr_buffer *buffer;
+    timespec when;
+};
+
+/** @return The number of bytes per pixel, or 0 if the format cannot be copied row by row. */
+int get_bytes_per_pixel(uint32_t format)
+{
+    switch (format)
+    {
+      case DRM_FORMAT_ARGB8888:
+      case DRM_FORMAT_XRGB8888:
+      case DRM_FORMAT_ABGR8888:
+      case DRM_FORMAT_XBGR8888:
+      case DRM_FORMAT_RGBA8888:
+      case DRM_FORMAT_RGBX8888:
+      case DRM_FORMAT_BGRA8888:
+      case DRM_FORMAT_BGRX8888:
+      case DRM_FORMAT_ARGB2101010:
+      case DRM_FORMAT_XRGB2101010:
+      case DRM_FORMAT_ABGR2101010:
+      case DRM_FORMAT_XBGR2101010:
+        return 4;
+
+      case DRM_FORMAT_RGB565:
+        return 2;
+
+      default:
+        return 0;
+    }
+}
+}
+
+std::optional<uint64_t> copy_damage_cpu(wlr_buffer *src, wlr_buffer *dst, const wf::region_t& damage)
+{
+    if ((src->width != dst->width) || (src->height != dst->height))
+    {
+        return {};
+    }
+
+    void *src_data, *dst_data;
+    uint32_t src_format, dst_format;
+    size_t src_stride, dst_stride;
+    if (!wlr_buffer_begin_data_ptr_access(src, WLR_BUFFER_DATA_PTR_ACCESS_READ,
+        &src_data, &src_format, &src_stride))
+    {
+        return {};
+    }
+
+    if (!wlr_buffer_begin_data_ptr_access(dst, WLR_BUFFER_DATA_PTR_ACCESS_WRITE,
+        &dst_data, &dst_format, &dst_stride))
+    {
+        wlr_buffer_end_data_ptr_access(src);
+        return {};
+    }
+
+    std::optional<uint64_t> copied;
+    const int bpp = get_bytes_per_pixel(src_format);
+    if ((src_format == dst_format) && (bpp > 0))
+    {
+        copied = 0;
+        for (const auto& box : damage & wlr_box{0, 0, src->width, src->height})
+        {
+            const size_t row_size = (size_t)(box.x2 - box.x1) * bpp;
+            for (int y = box.y1; y < box.y2; y++)
+            {
+                std::memcpy((char*)dst_data + y * dst_stride + box.x1 * bpp,
+                    (char*)src_data + y * src_stride + box.x1 * bpp, row_size);
+            }
+
+            *copied += row_size * (box.y2 - box.y1);
+        }
+    }
+
+    wlr_buffer_end_data_ptr_access(dst);
+    wlr_buffer_end_data_ptr_access(src);
+    return copied;
+}
+
+class output_capture_source_t
+{
+  public:
+    output_capture_source_t(wlr_output *output) : output(output)
+    {
+        wrapper.self = this;
+        wlr_ext_image_capture_source_v1_init(&wrapper.base, &source_impl);
+        update_constraints();
+
+        on_commit.set_callback([=] (void *data)
+        {
+            handle_commit(static_cast<wlr_output_event_commit*>(data));
+        });
+        on_commit.connect(&output->events.commit);
+    }
+
+    ~output_capture_source_t()
+    {
+        // Sources are destroyed together with their output, so there is no need to unlock the software
+        // cursors.
+        wlr_ext_image_capture_source_v1_finish(&wrapper.base);
+    }
+
+    wlr_ext_image_capture_source_v1 *get_base()
+    {
+        return &wrapper.base;
+    }
+
+  private:
+    // The wlroots source, with a back-pointer for the interface callbacks.
+    struct
+    {
+        wlr_ext_image_capture_source_v1 base;
+        output_capture_source_t *self;
+    } wrapper;
+
+    wlr_output *output;
+    wf::wl_listener_wrapper on_commit;
+    int num_started = 0;
+    bool software_cursors_locked = false;
+
+    static output_capture_source_t *from_base(wlr_ext_image_capture_source_v1 *base)
+    {
+        return reinterpret_cast<decltype(wrapper)*>(base)->self;
+    }
+
+    static const wlr_ext_image_capture_source_v1_interface source_impl;
+
+    void update_constraints()
+    {
+        if (!wlr_output_configure_primary_swapchain(output, nullptr, &output->swapchain))
+        {
+            LOGE("Failed to configure the swapchain of ", output->name, " for capturing!");
+            return;
+        }
+
+        wlr_ext_image_capture_source_v1_set_constraints_from_swapchain(&wrapper.base,
+            output->swapchain, output->renderer);
+    }
+
+    void start(bool with_cursors)
+    {
+        ++num_started;
+        if (with_cursors && !software_cursors_locked)
+        {
+            wlr_output_lock_software_cursors(output, true);
+            software_cursors_locked = true;
+        }
+    }
+
+    void stop()
+    {
+        --num_started;
+        if ((num_started == 0) && software_cursors_locked)
+        {
+            wlr_output_lock_software_cursors(output, false);
+            software_cursors_locked = false;
+        }
+    }
+
+    void schedule_frame()
+    {
+        // The output is repainted only if it is actually damaged. Otherwise, the capture stays pending
+        // until the next damage, instead of delivering an identical frame.
+        if (auto wo = wf::get_core().output_layout->find_output(output))
+        {
+            wo->render->schedule_redraw();
+        }
+    }
+
+    void handle_commit(wlr_output_event_commit *ev)
+    {
+        if (ev->state->committed & (WLR_OUTPUT_STATE_MODE | WLR_OUTPUT_STATE_RENDER_FORMAT))
+        {
+            update_constraints();
+        }
+
+        if ((num_started == 0) || !(ev->state->committed & WLR_OUTPUT_STATE_BUFFER))
+        {
+            return;
+        }
+
+        wlr_buffer *buffer = ev->state->buffer;
+        wf::region_t damage;
+        if (ev->state->committed & WLR_OUTPUT_STATE_DAMAGE)
+        {
+            // This is the swap damage of the render manager (or the client damage, for direct scanout).
+            damage = wf::region_t{&ev->state->damage};
+        } else
+        {
+            damage = wlr_box{0, 0, buffer->width, buffer->height};
+        }
+
+        if (damage.empty())
+        {
+            return;
+        }
+
+        output_frame_event_t event;
+        event.base.damage = damage.to_pixman();
+        event.buffer = buffer;
+        clock_gettime(CLOCK_MONOTONIC, &event.when);
+        wl_signal_emit_mutable(&wrapper.base.events.frame, &event.base);
+    }
+
+    void copy_frame(wlr_ext_image_copy_capture_frame_v1 *frame, output_frame_event_t *event)
+    {
+        auto wo = wf::get_core().output_layout->find_output(output);
+        if (!wo)
+        {
+            wlr_ext_image_copy_capture_frame_v1_fail(frame,
+                EXT_IMAGE_COPY_CAPTURE_FRAME_V1_FAILURE_REASON_STOPPED);
+            return;
+        }
+
+        auto stats = wo->get_data_safe<output_capture_stats_t>();
+        wf::region_t buffer_damage{&frame->buffer_damage};
+        if (auto copied = copy_damage_cpu(event->buffer, frame->buffer, buffer_damage))
+        {
+            stats->bytes_copied += *copied;
+        } else if (wlr_ext_image_copy_capture_frame_v1_copy_buffer(frame, event->buffer, output->renderer))
+        {
+            ++stats->full_copies;
+            stats->bytes_copied += (uint64_t)frame->buffer->width * frame->buffer->height * 4;
+        } else
+        {
+            // The frame has already been failed by wlroots.
+            return;
+        }
+
+        ++stats->frames;
+        wlr_ext_image_copy_capture_frame_v1_ready(frame, output->transform, &event->when);
+    }
+};
+
+const wlr_ext_image_capture_source_v1_interface output_capture_source_t::source_impl = {
+    .start = [] (wlr_ext_image_capture_source_v1 *base, bool with_cursors)
+    {
+        from_base(base)->start(with_cursors);
+    },
+    .stop = [] (wlr_ext_image_capture_source_v1 *base)
+    {
+        from_base(base)->stop();
+    },
+    .schedule_frame = [] (wlr_ext_image_capture_source_v1 *base)
+    {
+        from_base(base)->schedule_frame();
+    },
+    .copy_frame = [] (wlr_ext_image_capture_source_v1 *base, wlr_ext_image_copy_capture_frame_v1 *frame,
+        wlr_ext_image_capture_source_v1_frame_event *event)
+    {
+        from_base(base)->copy_frame(frame, reinterpret_cast<output_frame_event_t*>(event));
+    },
+};
+
+static void handle_create_source(wl_client *client, wl_resource *resource, uint32_t new_id,
+    wl_resource *output_resource)
+{
+    auto manager = static_cast<output_capture_manager_t*>(wl_resource_get_user_data(resource));
+    wlr_output *output = wlr_output_from_resource(output_resource);
+    wlr_ext_image_capture_source_v1 *source = nullptr;
+    if (output)
+    {
+        source = manager->get_source(output)->get_base();
+    }
+
+    // For inert outputs, an inert source is created.
+    if (!wlr_ext_image_capture_source_v1_create_resource(source, client, new_id))
+    {
+        wl_client_post_no_memory(client);
+    }
+}
+
+static void handle_manager_destroy(wl_client *client, wl_resource *resource)
+{
+    wl_resource_destroy(resource);
+}
+
+static const struct ext_output_image_capture_source_manager_v1_interface manager_impl = {
+    .create_source = handle_create_source,
+    .destroy = handle_manager_destroy,
+};
+
+static void bind_manager(wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+    wl_resource *resource = wl_resource_create(client, &ext_output_image_capture_source_manager_v1_interface,
+        version, id);
+    if (!resource)
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &manager_impl, data, nullptr);
+}
+
+output_capture_manager_t::output_capture_manager_t(wl_display *display)
+{
+    global = wl_global_create(display, &ext_output_image_capture_source_manager_v1_interface, 1,
+        this, bind_manager);
+}
+
+output_capture_manager_t::~output_capture_manager_t()
+{
+    sources.clear();
+    wl_global_destroy(global);
+}
+
+output_capture_source_t *output_capture_manager_t::get_source(wlr_output *output)
+{
+    auto& entry = sources[output];
+    if (!entry)
+    {
+        entry = std::make_unique<output_entry_t>();
+        entry->source = std::make_unique<output_capture_source_t>(output);
+        entry->on_output_destroy.set_callback([this, output] (void*)
+        {
+            // The source uses the output, so it goes away right now. The entry holds the running listener.
+            auto it = sources.find(output);
+            it->second->source.reset();
+            it->second->on_output_destroy.disconnect();
+            destroyed_entries.push_back(std::move(it->second));
+            sources.erase(it);
+            free_destroyed_entries.run_once([this] ()
+            {
+                destroyed_entries.clear();
+            });
+        });
+        entry->on_output_destroy.connect(&output->events.destroy);
+    }
+
+    return entry->source.get();
+}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <wayfire/nonstd/wlroots-full.hpp>
+#include <wayfire/region.hpp>
+#include <wayfire/util.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace wf
+{
+class output_capture_source_t;
+
+/**
+ * Copy the damaged parts of @src into @dst on the CPU.
+ *
+ * @return The number of bytes copied, or std::nullopt if the buffers are not both accessible from the
+ *   CPU, or they have a different size or format.
+ */
+std::optional<uint64_t> copy_damage_cpu(wlr_buffer *src, wlr_buffer *dst, const wf::region_t& damage);
+
+/**
+ * Implements ext_output_image_capture_source_manager_v1 on top of Wayfire's render manager, in place of the
+ * generic wlroots implementation: frames are delivered only when the output is damaged, and on the pixman
+ * renderer only the damaged rectangles are copied into the client buffers, see output_capture_stats_t.
+ */
+class output_capture_manager_t
+{
+  public:
+    output_capture_manager_t(wl_display *display);
+    ~output_capture_manager_t();
+
+    /** Get the capture source for the given output, creating it if necessary. */
+    output_capture_source_t *get_source(wlr_output *output);
+
+  private:
+    /** The capture source of an output, and the listener which destroys it together with the output. */
+    struct output_entry_t
+    {
+        std::unique_ptr<output_capture_source_t> source;
+        wf::wl_listener_wrapper on_output_destroy;
+    };
+
+    wl_global *global;
+    std::map<wlr_output*, std::unique_ptr<output_entry_t>> sources;
+
+    // Entries of destroyed outputs. Their listener is still running when the output is destroyed, so they
+    // are freed on idle.
+    std::vector<std::unique_ptr<output_entry_t>> destroyed_entries;
+    wf::wl_idle_call free_destroyed_entries;
+};
+}
@@ -11,6 +11,7 @@
 
 #include "../output/output-impl.hpp"
 #include <xf86drmMode.h>
+#include <cmath>
 #include <cstring>
 #include <climits>
 #include <unordered_set>
@@ -825,14 +826,133 @@ struct output_layout_output_t
     wl_listener_wrapper on_frame;
     wlr_output *locked_cursors_on = NULL;
 
-    /** Render the output using texture as source */
-    void render_output(wlr_texture *texture)
+    /* The last buffer committed on the mirrored output */
+    wlr_buffer *source_back_buffer = NULL;
+    /* Damage on the mirrored output since our last frame, in its buffer-local coordinates */
+    wf::region_t source_damage;
+    /* Tracks which parts of our own swapchain buffers are outdated */
+    wlr_damage_ring mirror_damage_ring;
+    bool mirror_damage_ring_ready = false;
+    /* Whether to try scanning out the buffers of the mirrored output directly */
+    bool try_mirror_scanout = true;
+    bool mirror_scanout_active = false;
+
+    void damage_whole_mirror()
+    {
+        wlr_box whole = {0, 0, handle->width, handle->height};
+        wlr_damage_ring_add_box(&mirror_damage_ring, &whole);
+    }
+
+    /** Scale damage from the mirrored output's buffer to our buffer */
+    wf::region_t source_damage_to_local()
+    {
+        if ((source_back_buffer->width == handle->width) && (source_back_buffer->height == handle->height))
+        {
+            return source_damage;
+        }
+
+        const double sx = 1.0 * handle->width / source_back_buffer->width;
+        const double sy = 1.0 * handle->height / source_back_buffer->height;
+
+        wf::region_t result;
+        for (const auto& rect : source_damage)
+        {
+            // Round outwards, bilinear filtering may also spill over into the neighboring pixel.
+            const int x1 = std::max(0.0, std::floor(rect.x1 * sx) - 1);
+            const int y1 = std::max(0.0, std::floor(rect.y1 * sy) - 1);
+            const int x2 = std::ceil(rect.x2 * sx) + 1;
+            const int y2 = std::ceil(rect.y2 * sy) + 1;
+            result |= wlr_box{x1, y1, x2 - x1, y2 - y1};
+        }
+
+        result &= wlr_box{0, 0, handle->width, handle->height};
+        return result;
+    }
+
+    /**
+     * Try to display the mirrored output's buffer directly, without any copy. This is possible when the
+     * buffer has the same size and a format our primary plane supports.
+     */
+    bool try_scanout_source()
+    {
+        if (!try_mirror_scanout || (handle->transform != WL_OUTPUT_TRANSFORM_NORMAL) ||
+            (source_back_buffer->width != handle->width) || (source_back_buffer->height != handle->height))
+        {
+            return false;
+        }
+
+        wlr_output_state_setter_t frame;
+        wlr_output_state_set_buffer(&frame.pending, source_back_buffer);
+        wlr_output_state_set_damage(&frame.pending, source_damage.to_pixman());
+        if (!frame.test(handle))
+        {
+            LOGD(handle->name, ": cannot scan out buffers of the mirrored output, copying instead.");
+            try_mirror_scanout = false;
+            return false;
+        }
+
+        if (!frame.commit(handle))
+        {
+            return false;
+        }
+
+        // Our own swapchain buffers were not updated in the meantime.
+        damage_whole_mirror();
+        mirror_scanout_active = true;
+        return true;
+    }
+
+    /**
+     * Copy the damaged parts of the mirrored output's buffer into our own buffer.
+     *
+     * @return Whether the frame was committed.
+     */
+    bool render_output()
     {
         // TODO: use render-manager's functions, apply gamma, use our normal pass functions.
-        struct wlr_render_pass *pass = wlr_output_begin_render_pass(handle, &pending_state.pending, NULL);
+        wlr_output_state_setter_t frame;
+        if (!wlr_output_configure_primary_swapchain(handle, &frame.pending, &handle->swapchain))
+        {
+            LOGE("Failed to configure primary output swapchain for output ", handle->name);
+            return false;
+        }
+
+        wlr_buffer *buffer = wlr_swapchain_acquire(handle->swapchain);
+        if (!buffer)
+        {
+            LOGE("Failed to acquire buffer from the output swapchain!");
+            return false;
+        }
+
+        auto texture = wlr_texture_from_buffer(get_core().renderer, source_back_buffer);
+        if (!texture)
+        {
+            LOGE("Failed to export texture to dmabuf!");
+            wlr_buffer_unlock(buffer);
+            return false;
+        }
+
+        if (mirror_scanout_active)
+        {
+            mirror_scanout_active = false;
+            damage_whole_mirror();
+        }
+
+        wf::region_t frame_damage = source_damage_to_local();
+        wlr_damage_ring_add(&mirror_damage_ring, frame_damage.to_pixman());
+
+        // Parts which are outdated in this buffer: the new damage and the damage of the previous frames
+        // since the buffer was last used.
+        wf::region_t buffer_damage;
+        wlr_damage_ring_rotate_buffer(&mirror_damage_ring, buffer, buffer_damage.to_pixman());
+        buffer_damage &= wlr_box{0, 0, handle->width, handle->height};
+
+        struct wlr_render_pass *pass = wlr_renderer_begin_buffer_pass(handle->renderer, buffer, NULL);
         if (pass == NULL)
         {
-            return;
+            wlr_texture_destroy(texture);
+            wlr_buffer_unlock(buffer);
+            return false;
         }
 
         // Render other output as a fullscreen texture.
@@ -841,18 +961,26 @@ struct output_layout_output_t
         opts.alpha   = NULL;
         opts.blend_mode  = WLR_RENDER_BLEND_MODE_NONE;
         opts.filter_mode = WLR_SCALE_FILTER_BILINEAR;
-        opts.clip    = NULL;
+        opts.clip    = buffer_damage.to_pixman();
         opts.src_box = {0, 0, 0, 0};
         opts.dst_box = {0, 0, handle->width, handle->height};
         opts.transform = WL_OUTPUT_TRANSFORM_NORMAL;
         wlr_render_pass_add_texture(pass, &opts);
 
-        wlr_render_pass_submit(pass);
-        pending_state.commit(handle);
-    }
+        const bool pass_ok = wlr_render_pass_submit(pass);
+        wlr_texture_destroy(texture);
+        if (!pass_ok)
+        {
+            LOGE("Failed to submit mirror render pass on output ", handle->name);
+            wlr_buffer_unlock(buffer);
+            return false;
+        }
 
-    /* Load output contents and render them */
-    wlr_buffer *source_back_buffer = NULL;
+        wlr_output_state_set_buffer(&frame.pending, buffer);
+        wlr_output_state_set_damage(&frame.pending, frame_damage.to_pixman());
+        wlr_buffer_unlock(buffer);
+        return frame.commit(handle);
+    }
 
     void handle_frame()
     {
@@ -872,15 +1000,17 @@ struct output_layout_output_t
             return;
         }
 
-        auto texture = wlr_texture_from_buffer(get_core().renderer, source_back_buffer);
-        if (!texture)
+        if (source_damage.empty())
         {
-            LOGE("Failed to export texture to dmabuf!");
+            // The mirrored output did not change since our last frame.
             return;
         }
 
-        render_output(texture);
-        wlr_texture_destroy(texture);
+        // Keep the damage if the frame could not be shown, so that it is repainted on the next frame.
+        if (try_scanout_source() || render_output())
+        {
+            source_damage.clear();
+        }
     }
 
     void set_enabled(bool enabled)
@@ -928,6 +1058,15 @@ struct output_layout_output_t
         wlr_output_lock_software_cursors(wo->handle, true);
         locked_cursors_on = wo->handle;
 
+        wlr_damage_ring_init(&mirror_damage_ring);
+        mirror_damage_ring_ready = true;
+        damage_whole_mirror();
+        try_mirror_scanout    = true;
+        mirror_scanout_active = false;
+        source_damage.clear();
+
+        // We need a full frame from the mirrored output to start with.
+        wo->render->damage_whole();
         wlr_output_schedule_frame(handle);
         on_mirrored_frame.set_callback([=] (void *data)
         {
@@ -937,20 +1076,31 @@ struct output_layout_output_t
                 return;
             }
 
-            if (ev->state->buffer)
+            wlr_buffer *buffer = ev->state->buffer;
+            const bool size_changed = !source_back_buffer ||
+                (source_back_buffer->width != buffer->width) || (source_back_buffer->height != buffer->height);
+            if ((ev->state->committed & WLR_OUTPUT_STATE_DAMAGE) && !size_changed)
             {
-                if (source_back_buffer)
-                {
-                    wlr_buffer_unlock(source_back_buffer);
-                }
+                source_damage |= wf::region_t{&ev->state->damage};
+            } else
+            {
+                source_damage |= wlr_box{0, 0, buffer->width, buffer->height};
+            }
 
-                source_back_buffer = ev->state->buffer;
-                wlr_buffer_lock(ev->state->buffer);
+            if (source_back_buffer)
+            {
+                wlr_buffer_unlock(source_back_buffer);
             }
 
+            source_back_buffer = buffer;
+            wlr_buffer_lock(buffer);
+
             /* The mirrored output was repainted, schedule repaint
-             * for us as well */
-            wlr_output_schedule_frame(handle);
+             * for us as well, unless nothing changed. */
+            if (!source_damage.empty())
+            {
+                wlr_output_schedule_frame(handle);
+            }
         });
         on_mirrored_frame.connect(&wo->handle->events.commit);
 
@@ -972,6 +1122,13 @@ struct output_layout_output_t
             source_back_buffer = NULL;
         }
 
+        if (mirror_damage_ring_ready)
+        {
+            wlr_damage_ring_finish(&mirror_damage_ring);
+            mirror_damage_ring_ready = false;
+        }
+
+        source_damage.clear();
         on_mirrored_frame.disconnect();
         on_frame.disconnect();
     }
@@ -3,11 +3,17 @@
 #include <memory>
 #include <filesystem>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iterator>
 
 #include "config.h"
 #include "plugin-loader.hpp"
 #include "../core/wm.hpp"
 #include "wayfire/plugin.hpp"
+#include "wayfire/core.hpp"
+#include "wayfire/worker-pool.hpp"
+#include "wayfire/unstable/startup-timeline.hpp"
 #include <wayfire/util/log.hpp>
 
 wf::plugin_manager_t::plugin_manager_t()
@@ -56,6 +62,9 @@ void wf::plugin_manager_t::destroy_plugin(wf::loaded_plugin_t& p)
     p.instance->fini();
     p.instance.reset();
 
+    /* Background jobs submitted by the plugin may still reference its code */
+    wf::get_core().workers->flush();
+
     /* dlopen()/dlclose() do reference counting, so we should close the plugin
      * as many times as we opened it.
      *
@@ -79,7 +88,13 @@ void wf::plugin_manager_t::destroy_plugin(wf::loaded_plugin_t& p)
     }
 }
 
-static bool check_plugin_api_version(const std::string& path, bool can_unload_so)
+/**
+ * Check the API/ABI version of the plugin.
+ *
+ * @return The handle of the lazily opened plugin, which the caller has to close after opening the plugin
+ *   for real (when it can unload plugins at all), or NULL on failure.
+ */
+static void *check_plugin_api_version(const std::string& path)
 {
     // First, open everything just locally and in a lazy way.
     // We want to check just the API/ABI version.
@@ -89,7 +104,7 @@ static bool check_plugin_api_version(const std::string& path, bool can_unload_so
     if (handle == NULL)
     {
         LOGE("error loading plugin [", path, "]: ", dlerror());
-        return false;
+        return NULL;
     }
 
     /* Check plugin version */
@@ -98,7 +113,7 @@ static bool check_plugin_api_version(const std::string& path, bool can_unload_so
     {
         LOGE(path, ": missing getWayfireVersion()", path.c_str());
         dlclose(handle);
-        return false;
+        return NULL;
     }
 
     auto version_func = wf::union_cast<void*, wayfire_plugin_version_func>(version_func_ptr);
@@ -109,26 +124,29 @@ static bool check_plugin_api_version(const std::string& path, bool can_unload_so
         LOGE(path, ": API/ABI version mismatch: Wayfire is ",
             WAYFIRE_API_ABI_VERSION, ",  plugin built with ", plugin_abi_version);
         dlclose(handle);
-        return false;
+        return NULL;
     }
 
-    if (can_unload_so)
-    {
-        dlclose(handle);
-    }
-
-    return true;
+    return handle;
 }
 
 std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, bool can_unload_so)
 {
-    if (!check_plugin_api_version(path, can_unload_so))
+    void *check_handle = check_plugin_api_version(path);
+    if (!check_handle)
     {
         return {nullptr, nullptr};
     }
 
-    // RTLD_GLOBAL is required for RTTI/dynamic_cast across plugins
+    // RTLD_GLOBAL is required for RTTI/dynamic_cast across plugins.
+    // The plugin is still open from the version check, so this only promotes it to a global object with
+    // all symbols resolved, instead of mapping and relocating it a second time.
     void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if (can_unload_so)
+    {
+        dlclose(check_handle);
+    }
+
     if (handle == NULL)
     {
         LOGE("error loading plugin [", path, "]: ", dlerror());
@@ -149,6 +167,27 @@ std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, boo
     return {handle, new_instance_func_ptr};
 }
 
+/**
+ * Read the given file once, so that it is in the page cache when it is opened later.
+ * Safe to call from any thread.
+ */
+static void prefetch_file(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    static constexpr size_t chunk_size = 1 << 16;
+    std::vector<char> buffer(chunk_size);
+    while (read(fd, buffer.data(), chunk_size) > 0)
+    {}
+
+    close(fd);
+}
+
 std::optional<wf::loaded_plugin_t> wf::plugin_manager_t::load_plugin_from_file(std::string path)
 {
     auto [handle, new_instance_func_ptr] = wf::get_new_instance_handle(path, enable_so_unloading);
@@ -240,16 +279,33 @@ void wf::plugin_manager_t::reload_dynamic_plugins()
     }
 
     /* load new plugins */
-    std::vector<std::pair<std::string, wf::loaded_plugin_t>> pending_initialize;
+    std::vector<std::string> new_plugins;
+    std::copy_if(next_plugins.begin(), next_plugins.end(), std::back_inserter(new_plugins),
+        [&] (const std::string& plugin) { return !loaded_plugins.count(plugin); });
+
+    // dlopen() itself cannot run in parallel: the dynamic loader serializes it anyway, and it runs the
+    // static constructors of the plugins, which may access the configuration. What can be done in
+    // parallel is reading the plugin files from disk, which dominates on slow storage.
+    if (new_plugins.size() > 1)
+    {
+        for (auto& plugin : new_plugins)
+        {
+            wf::get_core().workers->submit([plugin] { prefetch_file(plugin); });
+        }
+
+        wf::get_core().workers->flush();
+    }
 
-    for (auto plugin : next_plugins)
+    auto timeline = wf::get_core().get_data_safe<wf::startup_timeline_t>();
+    std::vector<std::pair<std::string, wf::loaded_plugin_t>> pending_initialize;
+    for (auto& plugin : new_plugins)
     {
-        if (loaded_plugins.count(plugin))
+        std::optional<wf::loaded_plugin_t> ptr;
         {
-            continue;
+            wf::startup_phase_timer_t phase{timeline, "dlopen " + plugin};
+            ptr = load_plugin_from_file(plugin);
         }
 
-        std::optional<wf::loaded_plugin_t> ptr = load_plugin_from_file(plugin);
         if (ptr)
         {
             pending_initialize.emplace_back(plugin, std::move(*ptr));
@@ -264,6 +320,7 @@ void wf::plugin_manager_t::reload_dynamic_plugins()
     for (auto& [plugin, ptr] : pending_initialize)
     {
         try {
+            wf::startup_phase_timer_t phase{timeline, "init " + plugin};
             ptr.instance->init();
             loaded_plugins[plugin] = std::move(ptr);
         } catch (...)
@@ -185,28 +185,22 @@ void wf::bindings_repository_t::handle_gesture(const wf::touchgesture_t& gesture
         return;
     }
 
-    std::vector<std::function<void()>> callbacks;
+    std::vector<wf::activator_callback*> callbacks;
     for (auto& binding : this->priv->activators)
     {
         if (binding->activated_by->get_value().has_match(gesture))
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->callback;
-            callbacks.emplace_back([=] ()
-            {
-                wf::activator_data_t data = {
-                    .source = activator_source_t::GESTURE,
-                    .activation_data = 0
-                };
-                (*callback)(data);
-            });
+            callbacks.push_back(binding->callback);
         }
     }
 
-    for (auto& cb : callbacks)
+    wf::activator_data_t data = {
+        .source = activator_source_t::GESTURE,
+        .activation_data = 0
+    };
+    for (auto call : callbacks)
     {
-        cb();
+        (*call)(data);
     }
 }
 
@@ -9,6 +9,7 @@
 #include "wayfire/core.hpp"
 #include "wayfire/signal-definitions.hpp"
 #include <wayfire/option-wrapper.hpp>
+#include <wayfire/trace.hpp>
 
 namespace wf
 {
@@ -72,6 +73,7 @@ class input_manager_t
 template<class EventType>
 wf::input_event_processing_mode_t emit_device_event_signal(EventType *event, wlr_input_device *device)
 {
+    WF_TRACE_SCOPE("input-event-signal");
     wf::input_event_signal<EventType> data;
     data.event  = event;
     data.device = device;
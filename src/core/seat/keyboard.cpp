@@ -322,6 +322,7 @@ bool wf::keyboard_t::has_only_modifiers()
 
 bool wf::keyboard_t::handle_keyboard_key(uint32_t key, uint32_t state)
 {
+    WF_TRACE_SCOPE("keyboard-key");
     using namespace std::chrono;
 
     auto& input = wf::get_core_impl().input;
@@ -9,6 +9,7 @@
 #include <wayfire/debug.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/core.hpp>
+#include <wayfire/output.hpp>
 #include <wayfire/output-layout.hpp>
 
 wf::pointer_t::pointer_t(nonstd::observer_ptr<wf::input_manager_t> input,
@@ -33,10 +34,25 @@ wf::pointer_t::pointer_t(nonstd::observer_ptr<wf::input_manager_t> input,
     };
 
     wf::get_core().scene()->connect(&on_root_node_updated);
+
+    on_coalesced_motion_frame = [=] ()
+    {
+        flush_coalesced_motion();
+    };
+
+    on_coalesced_motion_output_removed = [=] (wf::output_pre_remove_signal *ev)
+    {
+        if (ev->output == coalesced_motion_output)
+        {
+            flush_coalesced_motion();
+        }
+    };
 }
 
 wf::pointer_t::~pointer_t()
-{}
+{
+    cancel_coalesced_motion();
+}
 
 bool wf::pointer_t::has_pressed_buttons() const
 {
@@ -124,6 +140,7 @@ void wf::pointer_t::transfer_grab(scene::node_ptr node)
     }
 
     LOGC(POINTER, "transfer grab ", cursor_focus.get(), " -> ", node.get());
+    cancel_coalesced_motion();
     auto old_focus = std::move(cursor_focus);
     cursor_focus = node;
     send_leave_to_focus(old_focus);
@@ -160,6 +177,7 @@ void wf::pointer_t::update_cursor_focus(wf::scene::node_ptr new_focus)
     }
 
     LOGC(POINTER, "Change cursor focus ", cursor_focus.get(), " -> ", new_focus.get());
+    cancel_coalesced_motion();
     auto old_focus = std::move(cursor_focus);
     cursor_focus = new_focus;
 
@@ -210,6 +228,8 @@ void wf::pointer_t::grab_surface(wf::scene::node_ptr node)
 void wf::pointer_t::handle_pointer_button(wlr_pointer_button_event *ev,
     input_event_processing_mode_t mode)
 {
+    WF_TRACE_SCOPE("pointer-button");
+    flush_coalesced_motion();
     seat->priv->break_mod_bindings();
     bool handled_in_binding = (mode != input_event_processing_mode_t::FULL);
 
@@ -294,6 +314,38 @@ void wf::pointer_t::send_button(wlr_pointer_button_event *ev, bool has_binding)
 }
 
 void wf::pointer_t::send_motion(uint32_t time_msec)
+{
+    if (!cursor_focus)
+    {
+        return;
+    }
+
+    if (!(cursor_focus->flags() & (int)wf::scene::node_flags::COALESCE_MOTION))
+    {
+        deliver_motion(time_msec);
+        return;
+    }
+
+    coalesced_motion_time = time_msec;
+    if (coalesced_motion_output)
+    {
+        return;
+    }
+
+    auto gc = wf::get_core().get_cursor_position();
+    coalesced_motion_output = wf::get_core().output_layout->get_output_at(gc.x, gc.y);
+    if (!coalesced_motion_output)
+    {
+        flush_coalesced_motion();
+        return;
+    }
+
+    coalesced_motion_output->render->add_effect(&on_coalesced_motion_frame, OUTPUT_EFFECT_PRE);
+    coalesced_motion_output->render->schedule_redraw();
+    wf::get_core().output_layout->connect(&on_coalesced_motion_output_removed);
+}
+
+void wf::pointer_t::deliver_motion(uint32_t time_msec)
 {
     if (cursor_focus)
     {
@@ -312,9 +364,31 @@ void wf::pointer_t::send_motion(uint32_t time_msec)
     }
 }
 
+void wf::pointer_t::flush_coalesced_motion()
+{
+    auto time_msec = coalesced_motion_time;
+    cancel_coalesced_motion();
+    if (time_msec)
+    {
+        deliver_motion(*time_msec);
+    }
+}
+
+void wf::pointer_t::cancel_coalesced_motion()
+{
+    coalesced_motion_time.reset();
+    if (coalesced_motion_output)
+    {
+        coalesced_motion_output->render->rem_effect(&on_coalesced_motion_frame);
+        coalesced_motion_output = nullptr;
+        on_coalesced_motion_output_removed.disconnect();
+    }
+}
+
 void wf::pointer_t::handle_pointer_motion(wlr_pointer_motion_event *ev,
     input_event_processing_mode_t mode)
 {
+    WF_TRACE_SCOPE("pointer-motion");
     /* XXX: maybe warp directly? */
     wlr_cursor_move(seat->priv->cursor->cursor, &ev->pointer->base, ev->delta_x, ev->delta_y);
     update_cursor_position(ev->time_msec);
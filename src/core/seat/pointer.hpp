@@ -9,6 +9,8 @@
 #include "wayfire/scene-input.hpp"
 #include "wayfire/signal-definitions.hpp"
 #include "wayfire/signal-provider.hpp"
+#include <wayfire/render-manager.hpp>
+#include <wayfire/output-layout.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 
 namespace wf
@@ -140,6 +142,24 @@ class pointer_t
      */
     void send_motion(uint32_t time_msec);
 
+    /** Send motion to the focus if the cursor has moved since the last motion event sent to it. */
+    void deliver_motion(uint32_t time_msec);
+
+    /**
+     * Motion for a focus with the COALESCE_MOTION flag, waiting to be delivered right before the next frame
+     * of coalesced_motion_output.
+     */
+    std::optional<uint32_t> coalesced_motion_time;
+    wf::output_t *coalesced_motion_output = nullptr;
+    wf::effect_hook_t on_coalesced_motion_frame;
+    wf::signal::connection_t<wf::output_pre_remove_signal> on_coalesced_motion_output_removed;
+
+    /** Deliver pending coalesced motion now. */
+    void flush_coalesced_motion();
+
+    /** Drop pending coalesced motion, for example because the focus changed. */
+    void cancel_coalesced_motion();
+
     /**
      * Send synthetic button release events to the old cursor focus.
      */
@@ -10,7 +10,9 @@
 #include "wayfire/view.hpp"
 #include <algorithm>
 #include <memory>
+#include <utility>
 #include <wayfire/signal-definitions.hpp>
+#include <wayfire/output.hpp>
 #include <wayfire/output-layout.hpp>
 #include <linux/input-event-codes.h>
 #include <wayfire/window-manager.hpp>
@@ -33,6 +35,7 @@ wf::tablet_tool_t::tablet_tool_t(wlr_tablet_tool *tool,
     this->on_destroy.set_callback([=] (void*)
     {
         this->tool->data = nullptr;
+        tablet->drop_pending_motion(this);
         tablet->tools_list.erase(
             std::remove_if(tablet->tools_list.begin(), tablet->tools_list.end(),
                 [this] (const auto& p) { return p.get() == this; }),
@@ -93,10 +96,24 @@ wf::tablet_tool_t::tablet_tool_t(wlr_tablet_tool *tool,
         wf::get_core_impl().seat->priv->cursor->set_cursor(&pev, false);
     });
     on_set_cursor.connect(&tool_v2->events.set_cursor);
+
+    on_hit_test_frame = [=] ()
+    {
+        update_tool_position(false);
+    };
+
+    on_hit_test_output_removed = [=] (wf::output_pre_remove_signal *ev)
+    {
+        if (ev->output == hit_test_output)
+        {
+            invalidate_hit_test();
+        }
+    };
 }
 
 wf::tablet_tool_t::~tablet_tool_t()
 {
+    invalidate_hit_test();
     tool->data = NULL;
 }
 
@@ -110,8 +127,76 @@ static inline wlr_surface *wlr_surface_from_node(wf::scene::node_ptr node)
     return nullptr;
 }
 
-void wf::tablet_tool_t::update_tool_position(bool real_update)
+std::optional<wf::scene::input_node_t> wf::tablet_tool_t::find_node_at(wf::pointf_t gc, bool cache)
+{
+    if (wlr_surface *surface = wlr_surface_from_node(hit_test_node))
+    {
+        auto local = get_node_local_coords(hit_test_node.get(), gc);
+        if (wlr_surface_point_accepts_input(surface, local.x, local.y))
+        {
+            return wf::scene::input_node_t{
+                .node = nonstd::make_observer(hit_test_node.get()),
+                .local_coords = local,
+            };
+        }
+    }
+
+    invalidate_hit_test();
+    auto input_node = wf::get_core().scene()->find_node_at(gc);
+    if (!cache || !input_node || !wlr_surface_from_node(input_node->node->shared_from_this()))
+    {
+        return input_node;
+    }
+
+    hit_test_output = wf::get_core().output_layout->get_output_at(gc.x, gc.y);
+    if (hit_test_output)
+    {
+        hit_test_node = input_node->node->shared_from_this();
+        hit_test_output->render->add_effect(&on_hit_test_frame, OUTPUT_EFFECT_PRE);
+        wf::get_core().output_layout->connect(&on_hit_test_output_removed);
+    }
+
+    return input_node;
+}
+
+void wf::tablet_tool_t::invalidate_hit_test()
+{
+    hit_test_node = nullptr;
+    if (hit_test_output)
+    {
+        hit_test_output->render->rem_effect(&on_hit_test_frame);
+        hit_test_output = nullptr;
+        on_hit_test_output_removed.disconnect();
+    }
+}
+
+bool wf::tablet_tool_t::send_motion(wf::pointf_t gc)
+{
+    auto focus = grabbed_node ? grabbed_node : proximity_surface;
+    wlr_surface *surface = wlr_surface_from_node(focus);
+    if (!surface)
+    {
+        return false;
+    }
+
+    auto local = get_node_local_coords(focus.get(), gc);
+    if (!grabbed_node && !wlr_surface_point_accepts_input(surface, local.x, local.y))
+    {
+        return false;
+    }
+
+    wlr_tablet_v2_tablet_tool_notify_motion(tool_v2, local.x, local.y);
+    return true;
+}
+
+void wf::tablet_tool_t::update_tool_position(bool real_update, bool motion_sent)
 {
+    if (!real_update)
+    {
+        // Something other than the tool itself changed, so the last hit test cannot be trusted.
+        invalidate_hit_test();
+    }
+
     if (!is_active)
     {
         return;
@@ -129,7 +214,7 @@ void wf::tablet_tool_t::update_tool_position(bool real_update)
         local = get_node_local_coords(focus_node.get(), gc);
     } else
     {
-        auto input_node = wf::get_core().scene()->find_node_at(gc);
+        auto input_node = find_node_at(gc, real_update);
         if (input_node)
         {
             focus_node = input_node->node->shared_from_this();
@@ -141,7 +226,7 @@ void wf::tablet_tool_t::update_tool_position(bool real_update)
 
     /* If focus is a wlr surface, send position */
     wlr_surface *next_focus = wlr_surface_from_node(focus_node);
-    if (next_focus && (real_update || focus_changed))
+    if (next_focus && ((real_update && !motion_sent) || focus_changed))
     {
         wlr_tablet_v2_tablet_tool_notify_motion(tool_v2, local.x, local.y);
     }
@@ -226,6 +311,10 @@ void wf::tablet_tool_t::passthrough_axis(wlr_tablet_tool_axis_event *ev)
 
 void wf::tablet_tool_t::handle_tip(wlr_tablet_tool_tip_event *ev)
 {
+    /* The cached hit test ignores windows stacked above the cached surface, so make sure that the tip goes
+     * to the surface which is actually under the tool. */
+    update_tool_position(false);
+
     /* Nothing to do without a proximity surface */
     if (!this->proximity_surface)
     {
@@ -250,6 +339,7 @@ void wf::tablet_tool_t::handle_tip(wlr_tablet_tool_tip_event *ev)
 
 void wf::tablet_tool_t::handle_button(wlr_tablet_tool_button_event *ev)
 {
+    update_tool_position(false);
     wlr_tablet_v2_tablet_tool_notify_button(tool_v2,
         (zwp_tablet_pad_v2_button_state)ev->button,
         (zwp_tablet_pad_v2_button_state)ev->state);
@@ -259,11 +349,13 @@ void wf::tablet_tool_t::handle_proximity(wlr_tablet_tool_proximity_event *ev)
 {
     if (ev->state == WLR_TABLET_TOOL_PROXIMITY_OUT)
     {
+        invalidate_hit_test();
         set_focus(nullptr);
         is_active = false;
     } else
     {
         is_active = true;
+        invalidate_hit_test();
         update_tool_position(true);
     }
 }
@@ -303,6 +395,7 @@ wf::tablet_tool_t*wf::tablet_t::ensure_tool(wlr_tablet_tool *tool)
 void wf::tablet_t::handle_tip(wlr_tablet_tool_tip_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_motion();
     if (should_use_absolute_positioning(ev->tool))
     {
         wlr_cursor_warp_absolute(cursor, &ev->tablet->base, ev->x, ev->y);
@@ -330,29 +423,100 @@ void wf::tablet_t::handle_tip(wlr_tablet_tool_tip_event *ev,
     }
 }
 
-void wf::tablet_t::handle_axis(wlr_tablet_tool_axis_event *ev,
-    input_event_processing_mode_t mode)
+wf::pointf_t wf::tablet_t::get_axis_position(wlr_tablet_tool_axis_event *ev)
 {
-    /* Update cursor position */
+    // Coalesced motion has not moved the cursor yet, so continue from where it is going to be.
+    wf::pointf_t position = {cursor->x, cursor->y};
+    if (pending_motion_tool)
+    {
+        position = pending_motion_position;
+    }
+
     if (should_use_absolute_positioning(ev->tool))
     {
-        double x = (ev->updated_axes & WLR_TABLET_TOOL_AXIS_X) ? ev->x : NAN;
-        double y = (ev->updated_axes & WLR_TABLET_TOOL_AXIS_Y) ? ev->y : NAN;
-        wlr_cursor_warp_absolute(cursor, &ev->tablet->base, x, y);
-    } else
+        double lx, ly;
+        wlr_cursor_absolute_to_layout_coords(cursor, &ev->tablet->base, ev->x, ev->y, &lx, &ly);
+        position.x = (ev->updated_axes & WLR_TABLET_TOOL_AXIS_X) ? lx : position.x;
+        position.y = (ev->updated_axes & WLR_TABLET_TOOL_AXIS_Y) ? ly : position.y;
+        return position;
+    }
+
+    double lx, ly;
+    wlr_output_layout_closest_point(wf::get_core().output_layout->get_handle(), NULL,
+        position.x + ev->dx, position.y + ev->dy, &lx, &ly);
+    return {lx, ly};
+}
+
+void wf::tablet_t::apply_motion(tablet_tool_t *tool, wlr_input_device *device, wf::pointf_t position,
+    bool motion_sent)
+{
+    wlr_cursor_warp_closest(cursor, device, position.x, position.y);
+    tool->update_tool_position(true, motion_sent);
+}
+
+void wf::tablet_t::flush_motion()
+{
+    if (pending_motion_tool)
     {
-        wlr_cursor_move(cursor, &ev->tablet->base, ev->dx, ev->dy);
+        apply_motion(std::exchange(pending_motion_tool, nullptr), pending_motion_device,
+            pending_motion_position, true);
     }
+}
+
+void wf::tablet_t::drop_pending_motion(tablet_tool_t *tool)
+{
+    if (pending_motion_tool == tool)
+    {
+        pending_motion_tool = nullptr;
+    }
+}
 
-    /* Update focus */
+void wf::tablet_t::handle_axis(wlr_tablet_tool_axis_event *ev,
+    input_event_processing_mode_t mode)
+{
     auto tool = ensure_tool(ev->tool);
-    tool->update_tool_position(true);
+
+    /* Pressure and tilt changes without movement do not need a cursor or focus update */
+    if (ev->updated_axes & (WLR_TABLET_TOOL_AXIS_X | WLR_TABLET_TOOL_AXIS_Y))
+    {
+        auto position = get_axis_position(ev);
+        if (motion_timer.is_connected() && ((pending_motion_tool == tool) || !pending_motion_tool) &&
+            tool->send_motion(position))
+        {
+            /* The client got the motion, the cursor and the focus follow at the end of the frame interval */
+            pending_motion_tool     = tool;
+            pending_motion_device   = &ev->tablet->base;
+            pending_motion_position = position;
+        } else
+        {
+            flush_motion();
+            apply_motion(tool, &ev->tablet->base, position, false);
+            if (!motion_timer.is_connected())
+            {
+                motion_timer.set_timeout(get_frame_interval_ms(position), [=] ()
+                {
+                    const bool had_motion = (pending_motion_tool != nullptr);
+                    flush_motion();
+                    return had_motion;
+                });
+            }
+        }
+    }
+
     tool->passthrough_axis(ev);
 }
 
+uint32_t wf::tablet_t::get_frame_interval_ms(wf::pointf_t position)
+{
+    auto output = wf::get_core().output_layout->get_output_at(position.x, position.y);
+    const int refresh_mhz = output ? output->handle->refresh : 0;
+    return (refresh_mhz > 0) ? std::max(1, 1'000'000 / refresh_mhz) : 16;
+}
+
 void wf::tablet_t::handle_button(wlr_tablet_tool_button_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_motion();
     /* Pass to the tool */
     ensure_tool(ev->tool)->handle_button(ev);
 }
@@ -360,6 +524,7 @@ void wf::tablet_t::handle_button(wlr_tablet_tool_button_event *ev,
 void wf::tablet_t::handle_proximity(wlr_tablet_tool_proximity_event *ev,
     input_event_processing_mode_t mode)
 {
+    flush_motion();
     if (should_use_absolute_positioning(ev->tool))
     {
         wlr_cursor_warp_absolute(cursor, &ev->tablet->base, ev->x, ev->y);
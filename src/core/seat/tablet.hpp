@@ -2,6 +2,8 @@
 #define WF_SEAT_TABLET_HPP
 
 #include <wayfire/util.hpp>
+#include <wayfire/render-manager.hpp>
+#include <optional>
 #include "seat-impl.hpp"
 #include "wayfire/object.hpp"
 #include "wayfire/signal-definitions.hpp"
@@ -26,7 +28,14 @@ struct tablet_tool_t
     /**
      * Called whenever a refocus of the tool is necessary
      */
-    void update_tool_position(bool real_update);
+    void update_tool_position(bool real_update, bool motion_sent = false);
+
+    /**
+     * Send the motion at @gc to the surface with the tool focus, without a hit test or moving the cursor.
+     *
+     * @return Whether the motion was sent, false if the tool is not over its focused surface anymore.
+     */
+    bool send_motion(wf::pointf_t gc);
 
     /** Set the proximity surface */
     bool set_focus(scene::node_ptr node);
@@ -51,6 +60,29 @@ struct tablet_tool_t
     void handle_proximity(wlr_tablet_tool_proximity_event *ev);
 
   private:
+    /**
+     * Find the node under the tool at @gc.
+     *
+     * Tablets report at a much higher rate than the display refreshes, so the surface found by the last full
+     * hit test is reused as long as it still accepts input at @gc. This check does not know about surfaces
+     * stacked above the cached one, so the cache lives only until the next frame of the output under the
+     * tool, where a full hit test verifies the focus. No frame is scheduled for that: restacking damages the
+     * output anyway. Tips, buttons and proximity always use a full hit test, so they are never sent to an
+     * occluded surface.
+     *
+     * @param cache Whether the result of a full hit test should be cached.
+     */
+    std::optional<scene::input_node_t> find_node_at(wf::pointf_t gc, bool cache);
+
+    /** Forget the cached hit test result, and stop waiting for the next frame to refresh it. */
+    void invalidate_hit_test();
+
+    /** The surface node found by the last full hit test. */
+    scene::node_ptr hit_test_node = nullptr;
+    wf::output_t *hit_test_output = nullptr;
+    wf::effect_hook_t on_hit_test_frame;
+    wf::signal::connection_t<wf::output_pre_remove_signal> on_hit_test_output_removed;
+
     wf::wl_listener_wrapper on_destroy, on_set_cursor;
     wf::wl_listener_wrapper on_tool_v2_destroy;
 
@@ -98,10 +130,33 @@ struct tablet_t : public input_device_impl_t
     wlr_tablet_v2_tablet *tablet_v2;
     std::vector<std::unique_ptr<tablet_tool_t>> tools_list;
 
+    /** Forget the coalesced motion of a tool which is being destroyed. */
+    void drop_pending_motion(tablet_tool_t *tool);
+
   private:
     wlr_tablet *handle;
     wlr_cursor *cursor;
 
+    /**
+     * Tablets report positions much faster than the display refreshes. Clients get every motion, but while
+     * the tool stays over its focused surface, the cursor and the focus are updated at most once per frame
+     * interval of the output under the tool: the first motion is applied right away, and the last one at
+     * the end of the interval. Other tool events apply the pending motion first.
+     */
+    tablet_tool_t *pending_motion_tool = nullptr;
+    wlr_input_device *pending_motion_device = nullptr;
+    wf::pointf_t pending_motion_position;
+    wf::wl_timer<true> motion_timer;
+
+    /** Get the position the axis event moves the tool to, in layout coordinates. */
+    wf::pointf_t get_axis_position(wlr_tablet_tool_axis_event *ev);
+    /** Move the cursor to @position and update the focus of the tool. */
+    void apply_motion(tablet_tool_t *tool, wlr_input_device *device, wf::pointf_t position,
+        bool motion_sent);
+    /** Apply the coalesced motion, if any. */
+    void flush_motion();
+    uint32_t get_frame_interval_ms(wf::pointf_t position);
+
     /**
      * Get the wayfire tool associated with the wlr tool.
      * The wayfire tool will be created if it doesn't exist yet.
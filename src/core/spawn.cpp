@@ -0,0 +1,256 @@
+#include "spawn.hpp"
+#include <wayfire/util/log.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+/**
+ * A request to the spawn helper. It is followed by payload_size bytes: the command and then the
+ * environment entries, each terminated by a NUL byte. The helper replies with the PID of the command, or 0.
+ */
+struct spawn_request_t
+{
+    uint64_t payload_size;
+    uint64_t nofile_limit;
+    uint8_t discard_output;
+};
+
+int helper_fd    = -1;
+pid_t helper_pid = -1;
+
+bool read_all(int fd, void *data, size_t size)
+{
+    char *bytes = (char*)data;
+    while (size > 0)
+    {
+        ssize_t ret = read(fd, bytes, size);
+        if ((ret < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+
+        if (ret <= 0)
+        {
+            return false;
+        }
+
+        bytes += ret;
+        size  -= ret;
+    }
+
+    return true;
+}
+
+bool write_all(int fd, const void *data, size_t size)
+{
+    const char *bytes = (const char*)data;
+    while (size > 0)
+    {
+        ssize_t ret = send(fd, bytes, size, MSG_NOSIGNAL);
+        if ((ret < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+
+        if (ret <= 0)
+        {
+            return false;
+        }
+
+        bytes += ret;
+        size  -= ret;
+    }
+
+    return true;
+}
+
+[[noreturn]] void exec_command(const char *command, char *const envp[], rlim_t nofile_limit,
+    bool discard_output)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = std::min(nofile_limit, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    if (discard_output)
+    {
+        int dev_null = open("/dev/null", O_WRONLY);
+        dup2(dev_null, 1);
+        dup2(dev_null, 2);
+        close(dev_null);
+    }
+
+    signal(SIGPIPE, SIG_DFL);
+    const char *argv[] = {"/bin/sh", "-c", command, NULL};
+    execve("/bin/sh", const_cast<char**>(argv), envp);
+    _exit(127);
+}
+
+/**
+ * Start the command in a grandchild of the helper, so that it is reparented to init once the intermediate
+ * child exits, and return its PID.
+ */
+pid_t launch(const char *command, char *const envp[], rlim_t nofile_limit, bool discard_output)
+{
+    static constexpr size_t READ_END  = 0;
+    static constexpr size_t WRITE_END = 1;
+
+    int pipe_fd[2];
+    if (pipe2(pipe_fd, O_CLOEXEC) == -1)
+    {
+        return 0;
+    }
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(pipe_fd[READ_END]);
+        pid_t grandchild = fork();
+        if (grandchild == 0)
+        {
+            exec_command(command, envp, nofile_limit, discard_output);
+        }
+
+        if (write(pipe_fd[WRITE_END], &grandchild, sizeof(grandchild)) != sizeof(grandchild))
+        {
+            _exit(EXIT_FAILURE);
+        }
+
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(pipe_fd[WRITE_END]);
+    pid_t pid = 0;
+    if (child > 0)
+    {
+        waitpid(child, nullptr, 0);
+        if ((read(pipe_fd[READ_END], &pid, sizeof(pid)) != sizeof(pid)) || (pid < 0))
+        {
+            pid = 0;
+        }
+    }
+
+    close(pipe_fd[READ_END]);
+    return pid;
+}
+
+[[noreturn]] void run_helper(int fd)
+{
+    spawn_request_t request;
+    std::vector<char> payload;
+    std::vector<char*> strings;
+    while (read_all(fd, &request, sizeof(request)))
+    {
+        payload.resize(request.payload_size);
+        if (!read_all(fd, payload.data(), payload.size()))
+        {
+            break;
+        }
+
+        pid_t pid = 0;
+        if (!payload.empty() && (payload.back() == '\0'))
+        {
+            strings.clear();
+            for (size_t i = 0; i < payload.size(); i += strlen(&payload[i]) + 1)
+            {
+                strings.push_back(&payload[i]);
+            }
+
+            strings.push_back(nullptr);
+            pid = launch(strings[0], strings.data() + 1, request.nofile_limit, request.discard_output);
+        }
+
+        if (!write_all(fd, &pid, sizeof(pid)))
+        {
+            break;
+        }
+    }
+
+    _exit(EXIT_SUCCESS);
+}
+}
+
+bool wf::start_spawn_helper(bool drop_privileges)
+{
+    if (helper_fd != -1)
+    {
+        return true;
+    }
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1)
+    {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        if (drop_privileges && ((getuid() != geteuid()) || (getgid() != getegid())) &&
+            ((setgid(getgid()) != 0) || (setuid(getuid()) != 0)))
+        {
+            _exit(EXIT_FAILURE);
+        }
+
+        run_helper(fds[1]);
+    }
+
+    close(fds[1]);
+    if (pid == -1)
+    {
+        close(fds[0]);
+        return false;
+    }
+
+    helper_fd  = fds[0];
+    helper_pid = pid;
+    return true;
+}
+
+pid_t wf::spawn_command(const std::string& command, const std::vector<std::string>& env,
+    rlim_t nofile_limit, bool discard_output)
+{
+    if (helper_fd == -1)
+    {
+        LOGE("Cannot run \"", command, "\": the spawn helper is not running.");
+        return 0;
+    }
+
+    std::string payload = command;
+    payload.push_back('\0');
+    for (auto& entry : env)
+    {
+        payload += entry;
+        payload.push_back('\0');
+    }
+
+    spawn_request_t request = {payload.size(), nofile_limit, discard_output};
+    pid_t pid = 0;
+    if (!write_all(helper_fd, &request, sizeof(request)) ||
+        !write_all(helper_fd, payload.data(), payload.size()) ||
+        !read_all(helper_fd, &pid, sizeof(pid)))
+    {
+        LOGE("The spawn helper exited, commands can no longer be run.");
+        close(helper_fd);
+        helper_fd = -1;
+        waitpid(helper_pid, nullptr, WNOHANG);
+        return 0;
+    }
+
+    if (pid == 0)
+    {
+        LOGE("Failed to run \"", command, "\"");
+    }
+
+    return pid;
+}
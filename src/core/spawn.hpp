@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+namespace wf
+{
+/**
+ * Fork the spawn helper, a small process which starts the commands for spawn_command().
+ *
+ * Forking the compositor itself copies the page tables of everything it has mapped, which gets slow once
+ * many buffers are allocated. The helper is forked before that happens, so the forks it does stay cheap.
+ * It has to be started before any other thread is created, and exits when the compositor closes its end
+ * of the connection.
+ *
+ * @param drop_privileges Whether the helper should drop to the real user and group IDs, see
+ *   drop_permissions() in main.cpp.
+ *
+ * @return Whether the helper is running.
+ */
+bool start_spawn_helper(bool drop_privileges);
+
+/**
+ * Start a command with /bin/sh -c in the spawn helper.
+ *
+ * The helper forks twice, so the command is reparented to init and never becomes a child of the caller.
+ * The command gets the given environment and soft limit of open files, and SIGPIPE at its default
+ * disposition. This blocks until the helper reports the PID of the command.
+ *
+ * @param command The command, as passed to sh -c.
+ * @param env The environment of the command, as NAME=value entries.
+ * @param nofile_limit The soft limit of open files for the command.
+ * @param discard_output Whether to redirect stdout and stderr to /dev/null.
+ *
+ * @return The PID of the command, or 0 on failure.
+ */
+pid_t spawn_command(const std::string& command, const std::vector<std::string>& env, rlim_t nofile_limit,
+    bool discard_output);
+}
@@ -0,0 +1,147 @@
+#include "wayfire/trace.hpp"
+#include "wayfire/core.hpp"
+#include "wayfire/worker-pool.hpp"
+#include <wayfire/util/log.hpp>
+
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic<bool> wf::trace::recording{false};
+
+namespace
+{
+struct trace_event_t
+{
+    const char *name;
+    int64_t start_us;
+    int64_t duration_us;
+    int tid;
+};
+
+/* Upper bound on the number of events of a single recording (32 MiB), later events are dropped. */
+constexpr size_t MAX_EVENTS = 1 << 20;
+
+struct trace_state_t
+{
+    std::mutex mutex;
+    std::string path;
+    std::vector<trace_event_t> events;
+    uint64_t dropped = 0;
+};
+
+trace_state_t& get_state()
+{
+    static trace_state_t state;
+    return state;
+}
+
+int get_thread_id()
+{
+    static thread_local int tid = syscall(SYS_gettid);
+    return tid;
+}
+
+bool write_trace(const std::string& path, const std::vector<trace_event_t>& events)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    const int pid = getpid();
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        auto& ev = events[i];
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d}",
+            i > 0 ? "," : "", ev.name, (long long)ev.start_us, (long long)ev.duration_us, pid, ev.tid);
+    }
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+}
+
+int64_t wf::trace::now_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1'000'000ll + ts.tv_nsec / 1000;
+}
+
+void wf::trace::record(const char *name, int64_t start_us, int64_t duration_us)
+{
+    auto& state = get_state();
+    std::lock_guard lock{state.mutex};
+    if (!recording.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    if (state.events.size() >= MAX_EVENTS)
+    {
+        ++state.dropped;
+        return;
+    }
+
+    state.events.push_back({name, start_us, duration_us, get_thread_id()});
+}
+
+bool wf::trace::start(const std::string& path)
+{
+    auto& state = get_state();
+    std::lock_guard lock{state.mutex};
+    if (recording)
+    {
+        return false;
+    }
+
+    state.path = path;
+    state.events.clear();
+    state.events.reserve(4096);
+    state.dropped = 0;
+    recording  = true;
+    LOGI("Started recording a trace to ", path);
+    return true;
+}
+
+int64_t wf::trace::stop()
+{
+    auto& state = get_state();
+    auto events = std::make_shared<std::vector<trace_event_t>>();
+    std::string path;
+    {
+        std::lock_guard lock{state.mutex};
+        if (!recording)
+        {
+            return -1;
+        }
+
+        recording = false;
+        std::swap(*events, state.events);
+        path = state.path;
+        if (state.dropped > 0)
+        {
+            LOGW("Trace buffer was full, dropped ", state.dropped, " events");
+        }
+    }
+
+    wf::get_core().workers->submit([=] ()
+    {
+        if (!write_trace(path, *events))
+        {
+            LOGE("Failed to write trace to ", path);
+        }
+    }, [=] ()
+    {
+        LOGI("Wrote trace with ", events->size(), " events to ", path);
+    });
+
+    return events->size();
+}
@@ -1,6 +1,7 @@
 #include "wayfire/option-wrapper.hpp"
 #include "wayfire/txn/transaction-object.hpp"
 #include <wayfire/txn/transaction.hpp>
+#include <wayfire/trace.hpp>
 #include <sstream>
 #include <wayfire/debug.hpp>
 
@@ -47,6 +48,7 @@ void wf::txn::transaction_t::add_object(transaction_object_sptr object)
 
 void wf::txn::transaction_t::commit()
 {
+    WF_TRACE_SCOPE("txn-commit");
     LOGC(TXN, "Committing transaction ", this, " with timeout ", this->timeout);
     if (this->objects.empty())
     {
@@ -74,6 +76,7 @@ void wf::txn::transaction_t::commit()
 
 void wf::txn::transaction_t::apply(bool did_timeout)
 {
+    WF_TRACE_SCOPE("txn-apply");
     on_object_ready.disconnect();
 
     LOGC(TXN, "Applying transaction ", this, " timed_out: ", did_timeout);
@@ -0,0 +1,210 @@
+/* Needed for pipe2 */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <wayfire/worker-pool.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/debug.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+struct wf::worker_pool_t::impl
+{
+    struct task_t
+    {
+        job_t job;
+        job_t on_done;
+    };
+
+    int max_threads;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::condition_variable idle_cv;
+    std::deque<task_t> queue;
+    std::vector<job_t> finished;
+    int active = 0;
+    // Threads waiting for a job. A job queued while one of them is woken up stays in the queue until then.
+    int idle = 0;
+    bool stopping = false;
+
+    // The worker threads wake up the main loop by writing to notify_fd[1].
+    int notify_fd[2] = {-1, -1};
+    wl_event_source *notify_source = nullptr;
+
+    void worker_main()
+    {
+        std::unique_lock lock{mutex};
+        while (true)
+        {
+            ++idle;
+            queue_cv.wait(lock, [&] { return stopping || !queue.empty(); });
+            --idle;
+            if (stopping)
+            {
+                return;
+            }
+
+            auto task = std::move(queue.front());
+            queue.pop_front();
+            ++active;
+
+            lock.unlock();
+            task.job();
+            lock.lock();
+
+            --active;
+            if (task.on_done)
+            {
+                const bool needs_wakeup = finished.empty();
+                finished.push_back(std::move(task.on_done));
+                if (needs_wakeup)
+                {
+                    char c = 0;
+                    if (write(notify_fd[1], &c, 1) < 0)
+                    {
+                        LOGE("Failed to wake up the main loop from a worker thread: ", strerror(errno));
+                    }
+                }
+            }
+
+            if (queue.empty() && (active == 0))
+            {
+                idle_cv.notify_all();
+            }
+        }
+    }
+
+    void ensure_thread_available()
+    {
+        // Each idle thread takes one of the queued jobs, start a new one only for the remaining jobs.
+        if (((int)queue.size() > idle) && ((int)threads.size() < max_threads))
+        {
+            threads.emplace_back([this] { worker_main(); });
+        }
+    }
+
+    void dispatch_finished()
+    {
+        char buf[64];
+        while (read(notify_fd[0], buf, sizeof(buf)) > 0)
+        {}
+
+        std::vector<job_t> callbacks;
+        {
+            std::lock_guard lock{mutex};
+            std::swap(callbacks, finished);
+        }
+
+        for (auto& cb : callbacks)
+        {
+            cb();
+        }
+    }
+
+    static int handle_notify(int fd, uint32_t mask, void *data)
+    {
+        ((impl*)data)->dispatch_finished();
+        return 0;
+    }
+};
+
+wf::worker_pool_t::worker_pool_t(int max_threads)
+{
+    priv = std::make_unique<impl>();
+    if (max_threads <= 0)
+    {
+        // Leave at least one core to the compositor thread, but do not hog big machines either.
+        max_threads = std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 4);
+    }
+
+    priv->max_threads = max_threads;
+    if (pipe2(priv->notify_fd, O_CLOEXEC | O_NONBLOCK) < 0)
+    {
+        LOGE("Failed to create worker pool notification pipe: ", strerror(errno),
+            ". Background jobs will run synchronously.");
+        priv->max_threads = 0;
+        return;
+    }
+
+    priv->notify_source = wl_event_loop_add_fd(wf::get_core().ev_loop, priv->notify_fd[0],
+        WL_EVENT_READABLE, impl::handle_notify, priv.get());
+}
+
+wf::worker_pool_t::~worker_pool_t()
+{
+    {
+        std::lock_guard lock{priv->mutex};
+        priv->stopping = true;
+        priv->queue.clear();
+    }
+
+    priv->queue_cv.notify_all();
+    for (auto& thread : priv->threads)
+    {
+        thread.join();
+    }
+
+    if (priv->notify_source)
+    {
+        wl_event_source_remove(priv->notify_source);
+    }
+
+    for (int fd : priv->notify_fd)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+void wf::worker_pool_t::submit(job_t job, job_t on_done)
+{
+    if (priv->max_threads == 0)
+    {
+        job();
+        if (on_done)
+        {
+            on_done();
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard lock{priv->mutex};
+        priv->queue.push_back({std::move(job), std::move(on_done)});
+        priv->ensure_thread_available();
+    }
+
+    priv->queue_cv.notify_one();
+}
+
+void wf::worker_pool_t::flush()
+{
+    {
+        std::unique_lock lock{priv->mutex};
+        priv->idle_cv.wait(lock, [&] { return priv->queue.empty() && (priv->active == 0); });
+    }
+
+    if (priv->notify_source)
+    {
+        priv->dispatch_finished();
+    }
+}
+
+int wf::worker_pool_t::get_max_threads() const
+{
+    return priv->max_threads;
+}
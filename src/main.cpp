@@ -15,7 +15,9 @@
 #include "wayfire/config-backend.hpp"
 #include "core/plugin-loader.hpp"
 #include "core/core-impl.hpp"
+#include "core/spawn.hpp"
 #include <wayfire/nonstd/wlroots.hpp>
+#include <wayfire/unstable/startup-timeline.hpp>
 
 static std::string get_version_string()
 {
@@ -45,6 +47,9 @@ static void print_help()
         std::endl;
     std::cout << " -R,  --damage-rerender   rerender damaged regions" << std::endl;
     std::cout << " -l,  --legacy-wl-drm     use legacy drm for wayland clients" << std::endl;
+    std::cout << "      --log-async[=size]  write the log from a background thread, buffering up to " <<
+        "size messages (default 4096)" << std::endl;
+    std::cout << "      --log-json          write the log as one JSON object per line" << std::endl;
     std::cout << " -v,  --version           print version and exit" << std::endl;
     exit(0);
 }
@@ -143,6 +148,9 @@ static void signal_handler(int signal)
 
     LOGE("Fatal error: ", error);
     wf::print_trace(false);
+    // The crash may have happened in the log writer, or while holding one of its locks, so do not wait
+    // for it indefinitely.
+    wf::log::flush_logging(std::chrono::milliseconds(500));
     std::_Exit(-1);
 }
 
@@ -292,6 +300,8 @@ int main(int argc, char *argv[])
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         {"exit-on-gles-error", no_argument, NULL, '$'},
+        {"log-async", optional_argument, NULL, 'A'},
+        {"log-json", no_argument, NULL, 'J'},
         {0, 0, NULL, 0}
     };
 
@@ -299,6 +309,8 @@ int main(int argc, char *argv[])
     std::string config_backend = WF_DEFAULT_CONFIG_BACKEND;
     std::vector<std::string> extended_debug_categories;
     bool allow_root = false;
+    size_t async_log_capacity = 0;
+    bool log_json = false;
 
     if (char *default_config_backend = getenv("WAYFIRE_DEFAULT_CONFIG_BACKEND"))
     {
@@ -347,6 +359,14 @@ int main(int argc, char *argv[])
             OpenGL::exit_on_gles_error = true;
             break;
 
+          case 'A':
+            async_log_capacity = optarg ? std::strtoul(optarg, NULL, 10) : 4096;
+            break;
+
+          case 'J':
+            log_json = true;
+            break;
+
           case 'd':
             log_level = wf::log::LOG_LEVEL_DEBUG;
 
@@ -378,10 +398,25 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* Fork the helper which starts commands while the process is still small and has a single thread. */
+    bool spawn_helper_started = wf::start_spawn_helper(!allow_root);
+
     /* Don't crash on SIGPIPE, e.g., when doing IPC to a client whose fd has been closed. */
     signal(SIGPIPE, SIG_IGN);
 
-    wf::log::initialize_logging(std::cout, log_level, wf::detect_color_mode());
+    wf::log::initialize_logging(std::cout, log_level, log_json ?
+        wf::log::LOG_COLOR_MODE_OFF : wf::detect_color_mode());
+    if (log_json)
+    {
+        wf::log::set_output_format(wf::log::LOG_FORMAT_JSON);
+    }
+
+    wf::log::enable_async_logging(async_log_capacity);
+
+    if (!spawn_helper_started)
+    {
+        LOGE("Failed to start the spawn helper, commands cannot be run.");
+    }
 
     parse_extended_debugging(extended_debug_categories);
     wlr_log_init(WLR_DEBUG, wlr_log_handler);
@@ -401,6 +436,8 @@ int main(int argc, char *argv[])
     {
         std::cout << "Unhandled exception" << std::endl;
         wf::print_trace(false);
+        // The exception may have been thrown in the log writer thread itself.
+        wf::log::flush_logging(std::chrono::milliseconds(500));
         std::abort();
     });
 
@@ -413,6 +450,9 @@ int main(int argc, char *argv[])
     core.argc = argc;
     core.argv = argv;
 
+    auto timeline = core.get_data_safe<wf::startup_timeline_t>();
+    int64_t phase_start = timeline->now_us();
+
     /** TODO: move this to core_impl constructor */
     core.display = display;
     core.ev_loop = wl_display_get_event_loop(core.display);
@@ -457,6 +497,7 @@ int main(int argc, char *argv[])
 
     core.allocator = wlr_allocator_autocreate(core.backend, core.renderer);
     assert(core.allocator);
+    timeline->add_phase("backend", phase_start);
 
     if (core.is_gles2())
     {
@@ -472,6 +513,7 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    phase_start = timeline->now_us();
     auto backend = load_backend(config_backend);
     if (!backend)
     {
@@ -484,7 +526,11 @@ int main(int argc, char *argv[])
     LOGD("Using configuration backend: ", config_backend);
     core.config_backend = std::unique_ptr<wf::config_backend_t>(backend);
     core.config_backend->init(display, *core.config, config_file);
+    timeline->add_phase("config", phase_start);
+
+    phase_start = timeline->now_us();
     core.init();
+    timeline->add_phase("core-init", phase_start);
 
     auto socket = choose_socket(core.display);
     if (!socket)
@@ -496,6 +542,7 @@ int main(int argc, char *argv[])
 
     core.wayland_display = socket.value();
     LOGI("Using socket name ", core.wayland_display);
+    phase_start = timeline->now_us();
     if (!wlr_backend_start(core.backend))
     {
         LOGE("Failed to initialize backend, exiting");
@@ -505,6 +552,8 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    timeline->add_phase("backend-start", phase_start);
+
     setenv("WAYLAND_DISPLAY", core.wayland_display.c_str(), 1);
     core.post_init();
 
@@ -519,5 +568,6 @@ int main(int argc, char *argv[])
 
     wf::compositor_core_impl_t::deallocate_core();
     LOGI("Shutdown successful!");
+    wf::log::enable_async_logging(0);
     return EXIT_SUCCESS;
 }
@@ -11,19 +11,29 @@
 #include "wayfire/scene.hpp"
 #include "wayfire/signal-definitions.hpp"
 #include "wayfire/view.hpp"
+#include "wayfire/toplevel-view.hpp"
 #include "wayfire/output.hpp"
 #include "wayfire/util.hpp"
 #include "../main.hpp"
 #include "wayfire/workspace-set.hpp" // IWYU pragma: keep
 #include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <tuple>
+#include <variant>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/nonstd/safe-list.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wlr/types/wlr_gamma_control_v1.h>
 #include <wayfire/output-layout.hpp>
+#include <wayfire/unstable/startup-timeline.hpp>
+#include <wayfire/trace.hpp>
 
 namespace wf
 {
@@ -82,7 +92,8 @@ struct swapchain_damage_manager_t
             wlr_output_transformed_resolution(this->output, &width, &height);
             wlr_region_transform(rotated.to_pixman(), rotated.to_pixman(),
                 wlr_output_transform_invert(this->output->transform), width, height);
-            damage_buffer(rotated, true);
+            // Damage from the output itself (e.g. software cursors), the scene did not change.
+            add_buffer_damage(rotated, true);
         });
 
         on_gamma_changed.set_callback([=] (void *data)
@@ -117,10 +128,26 @@ struct swapchain_damage_manager_t
         instance_manager->set_visibility_region(wo->get_layout_geometry());
     };
 
+    /**
+     * Whether the scene was damaged since the last frame, as opposed to damage caused only by the output
+     * itself (for example software cursors).
+     */
+    bool scene_damaged = true;
+
     /**
      * Damage the given region
      */
     void damage_buffer(const wf::region_t& region, bool repaint)
+    {
+        if (!region.empty())
+        {
+            scene_damaged = true;
+        }
+
+        add_buffer_damage(region, repaint);
+    }
+
+    void add_buffer_damage(const wf::region_t& region, bool repaint)
     {
         if (region.empty())
         {
@@ -143,6 +170,7 @@ struct swapchain_damage_manager_t
         }
 
         /* Wlroots expects damage after scaling */
+        scene_damaged = true;
         frame_damage |= box;
         wlr_damage_ring_add_box(&damage_ring, &box);
         if (repaint)
@@ -307,6 +335,33 @@ struct swapchain_damage_manager_t
             LOGE("Output commit failed!");
             return;
         }
+
+        if (!first_frame_committed)
+        {
+            first_frame_committed = true;
+            finish_startup_timeline();
+        }
+    }
+
+    static inline bool first_frame_committed = false;
+
+    /** Called when the first frame has been committed on any output. */
+    static void finish_startup_timeline()
+    {
+        auto timeline = wf::get_core().get_data_safe<startup_timeline_t>();
+        if (timeline->finished)
+        {
+            return;
+        }
+
+        timeline->add_phase("first-frame", 0);
+        timeline->finished = true;
+
+        LOGI("Startup timeline:");
+        for (auto& phase : timeline->phases)
+        {
+            LOGI("  ", phase.name, ": ", phase.start_us / 1000.0, "ms + ", phase.duration_us / 1000.0, "ms");
+        }
     }
 
     /**
@@ -421,17 +476,144 @@ struct effect_hook_manager_t
     }
 };
 
+/**
+ * A shader which applies a run of consecutive fragment post effects in a single pass.
+ */
+struct fused_post_effects_t
+{
+    std::vector<post_fragment_effect_t*> effects;
+    OpenGL::program_t program;
+
+    static std::string get_prefix(size_t idx)
+    {
+        return "wf_post" + std::to_string(idx) + "_";
+    }
+
+    void compile()
+    {
+        static const char *vertex_source =
+            R"(
+#version 100
+attribute highp vec2 position;
+attribute highp vec2 uvPosition;
+varying highp vec2 uvpos;
+
+void main() {
+    gl_Position = vec4(position.xy, 0.0, 1.0);
+    uvpos = uvPosition;
+}
+)";
+
+        std::ostringstream fragment;
+        fragment << "#version 100\n"
+                 << "precision mediump float;\n"
+                 << "varying highp vec2 uvpos;\n"
+                 << "uniform sampler2D smp;\n";
+
+        for (size_t i = 0; i < effects.size(); i++)
+        {
+            std::string source = effects[i]->source;
+            for (size_t pos = source.find('@'); pos != std::string::npos; pos = source.find('@', pos))
+            {
+                source.replace(pos, 1, get_prefix(i));
+            }
+
+            fragment << source << "\n";
+        }
+
+        fragment << "void main() {\n"
+                 << "    highp vec4 color = texture2D(smp, uvpos);\n";
+        for (size_t i = 0; i < effects.size(); i++)
+        {
+            fragment << "    color = " << get_prefix(i) << "apply(color);\n";
+        }
+
+        fragment << "    gl_FragColor = color;\n}\n";
+        program.free_resources();
+        program.set_simple(OpenGL::compile_program(vertex_source, fragment.str()));
+    }
+
+    /**
+     * Render the effects from @source to @destination, but only inside @damage (in buffer coordinates).
+     */
+    void render(wf::auxilliary_buffer_t& source, const wf::render_buffer_t& destination,
+        const wf::region_t& damage)
+    {
+        static const float vertex_data[] = {
+            -1.0f, -1.0f,
+            1.0f, -1.0f,
+            1.0f, 1.0f,
+            -1.0f, 1.0f
+        };
+
+        static const float coord_data[] = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            1.0f, 1.0f,
+            0.0f, 1.0f
+        };
+
+        wf::gles::run_in_context([&]
+        {
+            wf::gles::bind_render_buffer(destination);
+            program.use(wf::TEXTURE_TYPE_RGBA);
+            GL_CALL(glActiveTexture(GL_TEXTURE0));
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, wf::gles_texture_t::from_aux(source).tex_id));
+
+            program.attrib_pointer("position", 2, 0, vertex_data);
+            program.attrib_pointer("uvPosition", 2, 0, coord_data);
+            for (size_t i = 0; i < effects.size(); i++)
+            {
+                if (effects[i]->set_uniforms)
+                {
+                    effects[i]->set_uniforms(program, get_prefix(i));
+                }
+            }
+
+            GL_CALL(glDisable(GL_BLEND));
+            for (const auto& box : damage)
+            {
+                wf::gles::scissor_render_buffer(destination, wlr_box_from_pixman_box(box));
+                GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+            }
+
+            GL_CALL(glDisable(GL_SCISSOR_TEST));
+            GL_CALL(glEnable(GL_BLEND));
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+            program.deactivate();
+        });
+    }
+
+    ~fused_post_effects_t()
+    {
+        wf::gles::run_in_context_if_gles([&]
+        {
+            program.free_resources();
+        });
+    }
+};
+
 /**
  * A class to manage and run postprocessing effects
  */
 struct postprocessing_manager_t
 {
-    using post_container_t = wf::safe_list_t<post_hook_t*>;
+    using post_effect_t    = std::variant<post_hook_t*, post_fragment_effect_t*>;
+    using post_container_t = wf::safe_list_t<post_effect_t>;
     post_container_t post_effects;
     wf::auxilliary_buffer_t post_buffers[2];
     /* Buffer to which other operations render to */
     static constexpr uint32_t default_out_buffer = 0;
 
+    /* Compiled shaders for each run of consecutive fragment effects, in order */
+    std::vector<std::unique_ptr<fused_post_effects_t>> fused_effects;
+
+    /* The passes of the effects, rebuilt only when the effects or the output change, see build_passes() */
+    using pass_t = std::function<void(wf::auxilliary_buffer_t&, const wf::render_buffer_t&,
+        const wf::region_t&)>;
+    std::vector<pass_t> passes;
+    bool passes_dirty = true;
+
     output_t *output;
     uint32_t output_width, output_height;
     postprocessing_manager_t(output_t *output)
@@ -457,43 +639,140 @@ struct postprocessing_manager_t
 
         output_width  = width;
         output_height = height;
+        passes_dirty  = true;
         for (auto& buffer : post_buffers)
         {
             buffer.allocate({width, height});
         }
     }
 
-    void add_post(post_hook_t *hook)
+    void add_post(post_effect_t effect)
     {
-        post_effects.push_back(hook);
+        post_effects.push_back(effect);
+        fused_effects.clear();
+        passes_dirty = true;
         output->render->damage_whole_idle();
     }
 
-    void rem_post(post_hook_t *hook)
+    void rem_post(post_effect_t effect)
     {
-        post_effects.remove_all(hook);
+        post_effects.remove_all(effect);
+        fused_effects.clear();
+        passes_dirty = true;
         output->render->damage_whole_idle();
     }
 
+    /**
+     * @return Whether all post effects are damage-local, that is, running them only on the damaged region
+     *   of the output is enough.
+     */
+    bool is_damage_local()
+    {
+        bool local = true;
+        post_effects.for_each([&] (const post_effect_t& effect)
+        {
+            local &= std::holds_alternative<post_fragment_effect_t*>(effect);
+        });
+
+        return local;
+    }
+
+    /**
+     * Group the post effects into passes: each post hook is a pass on its own, and each run of consecutive
+     * fragment effects is fused into a single pass.
+     */
+    void build_passes()
+    {
+        std::vector<std::vector<post_fragment_effect_t*>> runs;
+        bool last_was_fragment = false;
+
+        passes.clear();
+        post_effects.for_each([&] (const post_effect_t& effect)
+        {
+            if (auto hook = std::get_if<post_hook_t*>(&effect))
+            {
+                passes.push_back([hook = *hook] (wf::auxilliary_buffer_t& source,
+                                                 const wf::render_buffer_t& destination, const wf::region_t&)
+                {
+                    (*hook)(source, destination);
+                });
+                last_was_fragment = false;
+                return;
+            }
+
+            auto fragment = std::get<post_fragment_effect_t*>(effect);
+            if (!last_was_fragment)
+            {
+                runs.emplace_back();
+                passes.push_back({});
+            }
+
+            runs.back().push_back(fragment);
+            last_was_fragment = true;
+        });
+
+        if (fused_effects.size() != runs.size())
+        {
+            fused_effects.clear();
+            fused_effects.resize(runs.size());
+        }
+
+        size_t run_idx = 0;
+        for (auto& pass : passes)
+        {
+            if (pass)
+            {
+                continue;
+            }
+
+            auto& fused = fused_effects[run_idx];
+            if (!fused || (fused->effects != runs[run_idx]))
+            {
+                fused = std::make_unique<fused_post_effects_t>();
+                fused->effects = runs[run_idx];
+                wf::gles::run_in_context([&] { fused->compile(); });
+            }
+
+            pass = [fused = fused.get()] (wf::auxilliary_buffer_t& source,
+                                          const wf::render_buffer_t& destination, const wf::region_t& damage)
+            {
+                fused->render(source, destination, damage);
+            };
+            ++run_idx;
+        }
+    }
+
     /* Run all postprocessing effects, rendering to alternating buffers and
      * finally to the screen.
      *
      * NB: 2 buffers just aren't enough. We render to the zero buffer, and then
      * we alternately render to the second and the third. The reason: We track
-     * damage. So, we need to keep the whole buffer each frame. */
-    void run_post_effects()
+     * damage. So, we need to keep the whole buffer each frame.
+     *
+     * @param damage The region (in buffer coordinates) which fragment effects need to repaint. */
+    void run_post_effects(const wf::region_t& damage)
     {
+        if (passes_dirty)
+        {
+            build_passes();
+            passes_dirty = false;
+        }
+
         int cur_idx = 0;
-        post_effects.for_each([&] (auto post) -> void
+        for (size_t i = 0; i < passes.size(); i++)
         {
             int next_idx = 1 - cur_idx;
-            wf::render_buffer_t dst_buffer = (post == post_effects.back() ?
+            wf::render_buffer_t dst_buffer = (i == passes.size() - 1 ?
                 final_target : post_buffers[next_idx].get_renderbuffer());
-            (*post)(post_buffers[cur_idx], dst_buffer);
+            passes[i](post_buffers[cur_idx], dst_buffer, damage);
             cur_idx = next_idx;
-        });
+        }
     }
 
+    /* The part of the output shown magnified, see render_manager::set_viewport() */
+    std::optional<wlr_fbox> viewport;
+    wlr_scale_filter_mode viewport_filter = WLR_SCALE_FILTER_BILINEAR;
+
     wf::render_target_t get_target_framebuffer() const
     {
         wf::render_target_t fb{
@@ -503,13 +782,190 @@ struct postprocessing_manager_t
         fb.geometry     = output->get_relative_geometry();
         fb.wl_transform = output->handle->transform;
         fb.scale = output->handle->scale;
+        if (viewport)
+        {
+            apply_viewport(fb);
+        }
 
         return fb;
     }
 
+    /**
+     * Adjust the target so that the viewport is mapped to the whole framebuffer.
+     *
+     * The geometry of a render target has integer coordinates, and it must be projected onto the framebuffer
+     * with the same scale on both axes. We therefore use the smallest geometry containing the viewport which
+     * has exactly the aspect ratio of the framebuffer, and position it with a subbuffer so that the viewport
+     * itself covers the framebuffer. The parts of the geometry outside of the framebuffer are never painted,
+     * because all damage is clipped to the framebuffer.
+     */
+    void apply_viewport(wf::render_target_t& fb) const
+    {
+        wf::dimensions_t size = {output->handle->width, output->handle->height};
+        if (fb.wl_transform & 1)
+        {
+            std::swap(size.width, size.height);
+        }
+
+        if ((size.width <= 0) || (size.height <= 0) || (viewport->width <= 0))
+        {
+            return;
+        }
+
+        // Framebuffer pixels per logical pixel inside the viewport
+        const double zoom_scale = size.width / viewport->width;
+        const double view_height = size.height / zoom_scale;
+
+        const int gcd    = std::gcd(size.width, size.height);
+        const int step_w = size.width / gcd;
+        const int step_h = size.height / gcd;
+
+        const int x = std::floor(viewport->x);
+        const int y = std::floor(viewport->y);
+        const int k = std::max({1.0,
+            std::ceil((viewport->x + viewport->width - x) / step_w),
+            std::ceil((viewport->y + view_height - y) / step_h)});
+
+        fb.geometry = {x, y, k * step_w, k * step_h};
+        // The real magnification, so that transformers render their auxiliary buffers at full resolution.
+        // The geometry itself is mapped to the whole framebuffer before the subbuffer is applied.
+        fb.scale = zoom_scale;
+        fb.filter_mode = viewport_filter;
+
+        // The subbuffer is given in buffer coordinates, i.e. before the output transform.
+        wlr_box subbuffer = {
+            (int)std::round((x - viewport->x) * zoom_scale),
+            (int)std::round((y - viewport->y) * zoom_scale),
+            (int)std::round(fb.geometry.width * zoom_scale),
+            (int)std::round(fb.geometry.height * zoom_scale),
+        };
+        wlr_box_transform(&subbuffer, &subbuffer, wlr_output_transform_invert(fb.wl_transform),
+            size.width, size.height);
+        fb.subbuffer = subbuffer;
+    }
+
     bool can_scanout() const
     {
-        return post_effects.size() == 0;
+        return (post_effects.size() == 0) && !viewport;
+    }
+};
+
+/**
+ * Manages software cursors on outputs without (usable) hardware cursor planes.
+ *
+ * Software cursors are drawn after everything else, directly on the output buffer. To avoid repainting the
+ * scene when only the cursors move, we keep a copy of the output contents without the cursors (a
+ * save-under buffer covering the whole output). It is updated with the damaged parts of each frame. When
+ * nothing but the cursors changed, the damaged area is restored from the copy and the cursors are drawn on
+ * top, in a single pass, without running the scene render pass at all.
+ */
+struct sw_cursor_manager_t
+{
+    output_t *output;
+    wf::auxilliary_buffer_t saved_scene;
+    bool saved_scene_valid = false;
+
+    sw_cursor_manager_t(output_t *output)
+    {
+        this->output = output;
+    }
+
+    bool has_software_cursors() const
+    {
+        wlr_output_cursor *cursor;
+        wl_list_for_each(cursor, &output->handle->cursors, link)
+        {
+            if (cursor->enabled && cursor->visible && (output->handle->hardware_cursor != cursor))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Make sure the save-under buffer exists if (and only if) the output has software cursors.
+     *
+     * @return Whether the output has software cursors.
+     */
+    bool prepare()
+    {
+        if (!has_software_cursors())
+        {
+            if (saved_scene.get_buffer())
+            {
+                saved_scene.free();
+            }
+
+            saved_scene_valid = false;
+            return false;
+        }
+
+        auto result = saved_scene.allocate({output->handle->width, output->handle->height}, 1.0,
+            {.needs_alpha = false});
+        if (result != buffer_reallocation_result_t::SAME)
+        {
+            saved_scene_valid = false;
+        }
+
+        return result != buffer_reallocation_result_t::FAILED;
+    }
+
+    /**
+     * Copy @damage from @source to @destination with a single pass. If @with_cursors is set, the software
+     * cursors are drawn afterwards in the same pass.
+     */
+    bool copy_damage(wlr_buffer *source, wlr_buffer *destination, const wf::region_t& damage,
+        bool with_cursors)
+    {
+        auto pass = wlr_renderer_begin_buffer_pass(output->handle->renderer, destination, nullptr);
+        if (!pass)
+        {
+            return false;
+        }
+
+        wlr_texture *texture = wlr_texture_from_buffer(output->handle->renderer, source);
+        if (texture)
+        {
+            wlr_render_texture_options opts{};
+            opts.texture = texture;
+            opts.blend_mode  = WLR_RENDER_BLEND_MODE_NONE;
+            opts.filter_mode = WLR_SCALE_FILTER_NEAREST;
+            opts.transform   = WL_OUTPUT_TRANSFORM_NORMAL;
+            opts.clip    = damage.to_pixman();
+            opts.dst_box = {0, 0, output->handle->width, output->handle->height};
+            wlr_render_pass_add_texture(pass, &opts);
+        }
+
+        if (with_cursors)
+        {
+            wlr_output_add_software_cursors_to_render_pass(output->handle, pass, damage.to_pixman());
+        }
+
+        const bool ok = wlr_render_pass_submit(pass);
+        if (texture)
+        {
+            wlr_texture_destroy(texture);
+        }
+
+        return ok && texture;
+    }
+
+    /**
+     * Store the damaged parts of a freshly rendered frame (before the cursors are drawn on it).
+     */
+    void save(wlr_buffer *frame, const wf::region_t& damage)
+    {
+        saved_scene_valid = copy_damage(frame, saved_scene.get_buffer(), damage, false);
+    }
+
+    /**
+     * Restore the damaged parts of the frame from the saved scene and draw the cursors on top.
+     */
+    bool restore(wlr_buffer *frame, const wf::region_t& damage)
+    {
+        return copy_damage(saved_scene.get_buffer(), frame, damage, true);
     }
 };
 
@@ -741,12 +1197,87 @@ struct repaint_delay_manager_t
      */
     int get_delay()
     {
-        return delay;
+        switch (content_type)
+        {
+          case output_content_type_t::GAME:
+            // Latency matters more than giving other clients time to submit their buffers.
+            return 0;
+
+          case output_content_type_t::PHOTO:
+            // The content rarely changes, so the repaint can start as late as possible and pick up
+            // all client updates which arrive until then in a single frame.
+            return std::max(delay, (int)(get_max_delay_us() / 1000));
+
+          default:
+            return std::max(delay, get_cadence_aligned_delay());
+        }
     }
 
+    std::map<const void*, commit_cadence_t> cadences;
+    output_content_type_t content_type = output_content_type_t::NONE;
+
   private:
     int delay = 0;
 
+    /**
+     * Find the latest time (relative to now) at which a surface with a stable cadence is going to commit,
+     * as long as the repaint can still start after that and finish in time for the next vblank.
+     *
+     * @return The delay in milliseconds, or 0 if repaints should not be aligned to any commit.
+     */
+    int get_cadence_aligned_delay()
+    {
+        const bool enabled = cadence_aligned_repaint || (content_type == output_content_type_t::VIDEO);
+        if (!enabled || cadences.empty() || (refresh_nsec <= 0))
+        {
+            return 0;
+        }
+
+        const int64_t now = wf::get_current_time_us();
+        const int64_t max_delay_us = get_max_delay_us();
+        // Start rendering a bit after the predicted commit, to account for jitter
+        constexpr int64_t slack_us = 1000;
+
+        int64_t aligned_delay_us = 0;
+        for (auto it = cadences.begin(); it != cadences.end();)
+        {
+            const auto& cadence = it->second;
+            if (now - cadence.last_commit_us > 2 * cadence.period_us)
+            {
+                // The surface stopped committing
+                it = cadences.erase(it);
+                continue;
+            }
+
+            const int64_t until_commit = cadence.last_commit_us + cadence.period_us - now + slack_us;
+            if ((until_commit > 0) && (until_commit <= max_delay_us))
+            {
+                aligned_delay_us = std::max(aligned_delay_us, until_commit);
+            }
+
+            ++it;
+        }
+
+        return (aligned_delay_us + 999) / 1000;
+    }
+
+    /**
+     * @return The latest time (relative to the frame event) at which the repaint can start and still finish
+     *   in time for the next vblank, in microseconds.
+     */
+    int64_t get_max_delay_us()
+    {
+        if (refresh_nsec <= 0)
+        {
+            return 0;
+        }
+
+        const int64_t refresh_us = refresh_nsec / 1000;
+        // Without a configured render time, assume that rendering takes at most half of the frame.
+        const int64_t render_budget_us = (max_render_time >= 0) ? max_render_time * 1000 : refresh_us / 2;
+        return std::max<int64_t>(0, refresh_us - render_budget_us);
+    }
+
     void update_delay(int delta)
     {
         int config_delay = std::max(0,
@@ -785,9 +1316,10 @@ struct repaint_delay_manager_t
     // Time of last frame
     int64_t last_pageflip = -1; // -1 is invalid
 
-    int64_t refresh_nsec;
+    int64_t refresh_nsec = 0;
     wf::option_wrapper_t<int> max_render_time{"core/max_render_time"};
     wf::option_wrapper_t<bool> dynamic_delay{"workarounds/dynamic_repaint_delay"};
+    wf::option_wrapper_t<bool> cadence_aligned_repaint{"workarounds/cadence_aligned_repaint"};
 
     wf::wl_listener_wrapper on_present;
 };
@@ -805,6 +1337,7 @@ class wf::render_manager::impl
     std::unique_ptr<postprocessing_manager_t> postprocessing;
     std::unique_ptr<depth_buffer_manager_t> depth_buffer_manager;
     std::unique_ptr<repaint_delay_manager_t> delay_manager;
+    std::unique_ptr<sw_cursor_manager_t> sw_cursors;
 
     wf::option_wrapper_t<wf::color_t> background_color_opt;
     std::unique_ptr<wf::render_pass_t> current_pass;
@@ -822,6 +1355,7 @@ class wf::render_manager::impl
         postprocessing = std::make_unique<postprocessing_manager_t>(o);
         depth_buffer_manager = std::make_unique<depth_buffer_manager_t>();
         delay_manager = std::make_unique<repaint_delay_manager_t>(o);
+        sw_cursors    = std::make_unique<sw_cursor_manager_t>(o);
 
         on_frame.set_callback([&] (void*)
         {
@@ -833,6 +1367,7 @@ class wf::render_manager::impl
             }
 
             delay_manager->start_frame();
+            update_content_type();
 
             auto repaint_delay = delay_manager->get_delay();
             // Leave a bit of time for clients to render, see
@@ -874,6 +1409,133 @@ class wf::render_manager::impl
         });
 
         reload_icc_profile();
+        content_type_scheduling.load_option(section, "content_type_scheduling");
+
+        output->connect(&on_view_fullscreen);
+        output->connect(&on_view_mapped);
+        output->connect(&on_view_disappeared);
+        output->connect(&on_view_minimized);
+        output->connect(&on_view_change_workspace);
+        output->connect(&on_workspace_changed);
+        output->connect(&on_wset_changed);
+        wf::get_core().connect(&on_view_moved_to_wset);
+    }
+
+    wf::option_wrapper_t<bool> content_type_scheduling;
+
+    // The fullscreen view on the current workspace. It is looked up again only after the views or the
+    // workspace of the output have changed, and not on every frame.
+    std::weak_ptr<wf::view_interface_t> fullscreen_view;
+    bool fullscreen_view_dirty = true;
+
+    wf::signal::connection_t<wf::view_fullscreen_signal> on_view_fullscreen = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wf::signal::connection_t<wf::view_mapped_signal> on_view_mapped = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wf::signal::connection_t<wf::view_disappeared_signal> on_view_disappeared = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wf::signal::connection_t<wf::view_minimized_signal> on_view_minimized = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wf::signal::connection_t<wf::view_change_workspace_signal> on_view_change_workspace = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wf::signal::connection_t<wf::workspace_changed_signal> on_workspace_changed = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wf::signal::connection_t<wf::workspace_set_changed_signal> on_wset_changed = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wf::signal::connection_t<wf::view_moved_to_wset_signal> on_view_moved_to_wset = [=] (auto)
+    {
+        fullscreen_view_dirty = true;
+    };
+
+    wayfire_view find_fullscreen_view()
+    {
+        if (fullscreen_view_dirty)
+        {
+            fullscreen_view_dirty = false;
+            fullscreen_view.reset();
+            for (auto& toplevel : output->wset()->get_views(WSET_MAPPED_ONLY | WSET_CURRENT_WORKSPACE))
+            {
+                if (toplevel->toplevel()->current().fullscreen)
+                {
+                    fullscreen_view = toplevel->weak_from_this();
+                    break;
+                }
+            }
+        }
+
+        auto view = fullscreen_view.lock();
+        return (view && view->is_mapped()) ? view.get() : nullptr;
+    }
+
+    /**
+     * Find the content type hint of the surface which the output's repaints should be scheduled for: the
+     * focused view, if it is on this output, otherwise a fullscreen view on the current workspace.
+     */
+    output_content_type_t find_content_type()
+    {
+        auto manager = wf::get_core().protocols.content_type;
+        if (!content_type_scheduling || !manager)
+        {
+            return output_content_type_t::NONE;
+        }
+
+        wayfire_view view = get_active_view_for_output(output);
+        if (!view)
+        {
+            view = find_fullscreen_view();
+        }
+
+        if (!view || !view->get_wlr_surface())
+        {
+            return output_content_type_t::NONE;
+        }
+
+        switch (wlr_surface_get_content_type_v1(manager, view->get_wlr_surface()))
+        {
+          case WP_CONTENT_TYPE_V1_TYPE_PHOTO:
+            return output_content_type_t::PHOTO;
+
+          case WP_CONTENT_TYPE_V1_TYPE_VIDEO:
+            return output_content_type_t::VIDEO;
+
+          case WP_CONTENT_TYPE_V1_TYPE_GAME:
+            return output_content_type_t::GAME;
+
+          default:
+            return output_content_type_t::NONE;
+        }
+    }
+
+    void update_content_type()
+    {
+        static const char *names[] = {"none", "photo", "video", "game"};
+        auto type = find_content_type();
+        if (type != delay_manager->content_type)
+        {
+            LOGC(RENDER, "Output ", output->to_string(), " switches to content type ", names[(int)type]);
+            delay_manager->content_type = type;
+        }
     }
 
     wlr_color_transform *icc_color_transform = NULL;
@@ -968,20 +1630,99 @@ class wf::render_manager::impl
      */
     bool do_direct_scanout()
     {
-        const bool can_scanout = !output_inhibit_counter && effects->can_scanout() &&
-            postprocessing->can_scanout() && wlr_output_is_direct_scanout_allowed(output->handle) &&
-            (icc_color_transform == nullptr);
-
-        if (!can_scanout || !env_allow_scanout)
+        auto blocker = get_scanout_precondition_blocker();
+        if (blocker != scene::scanout_blocker_t::NONE)
         {
+            current_blocker = {blocker, nullptr};
+            finish_scanout_attempt(false);
             return false;
         }
 
+        scanout_attempt_active = true;
         auto result = scene::try_scanout_from_list(
             damage_manager->instance_manager->get_instances(), output);
+
+        if (!current_blocker)
+        {
+            current_blocker = {(result == scene::direct_scanout::SKIP) ?
+                scene::scanout_blocker_t::NO_CANDIDATE : scene::scanout_blocker_t::OCCLUDED, nullptr};
+        }
+
+        finish_scanout_attempt(result == scene::direct_scanout::SUCCESS);
         return result == scene::direct_scanout::SUCCESS;
     }
 
+    direct_scanout_stats_t scanout_stats;
+    bool scanout_attempt_active = false;
+    std::optional<std::pair<scene::scanout_blocker_t, scene::node_t*>> current_blocker;
+
+    scene::scanout_blocker_t get_scanout_precondition_blocker()
+    {
+        if (!env_allow_scanout)
+        {
+            return scene::scanout_blocker_t::DISABLED;
+        } else if (output_inhibit_counter)
+        {
+            return scene::scanout_blocker_t::INHIBITED;
+        } else if (!effects->can_scanout())
+        {
+            return scene::scanout_blocker_t::EFFECT_HOOKS;
+        } else if (!postprocessing->can_scanout())
+        {
+            return scene::scanout_blocker_t::POST_EFFECTS;
+        } else if (icc_color_transform)
+        {
+            return scene::scanout_blocker_t::COLOR_TRANSFORM;
+        } else if (!wlr_output_is_direct_scanout_allowed(output->handle))
+        {
+            return scene::scanout_blocker_t::NOT_ALLOWED;
+        }
+
+        return scene::scanout_blocker_t::NONE;
+    }
+
+    void report_scanout_blocker(scene::scanout_blocker_t reason, scene::node_t *node)
+    {
+        if (scanout_attempt_active && !current_blocker)
+        {
+            current_blocker = {reason, node};
+        }
+    }
+
+    void finish_scanout_attempt(bool success)
+    {
+        auto [reason, node] = success ? std::pair{scene::scanout_blocker_t::NONE, (scene::node_t*)nullptr} :
+            current_blocker.value();
+        scanout_attempt_active = false;
+        current_blocker.reset();
+
+        // This runs on every frame, so only count the reason here. The node is described only when the
+        // blocker changes.
+        ++scanout_stats.attempts;
+        if (success)
+        {
+            ++scanout_stats.successes;
+        } else
+        {
+            ++scanout_stats.blockers[(size_t)reason];
+        }
+
+        if ((reason != scanout_stats.last_blocker) || (node != scanout_stats.last_blocker_node.lock().get()))
+        {
+            if (success)
+            {
+                LOGC(SCANOUT, "Direct scanout active on output ", output->to_string());
+            } else
+            {
+                LOGC(SCANOUT, "Direct scanout blocked on output ", output->to_string(), ": ",
+                    scene::scanout_blocker_to_string(reason), node ? " by " + node->stringify() : "");
+            }
+
+            scanout_stats.last_blocker = reason;
+            scanout_stats.last_blocker_node = node ? node->weak_from_this() : std::weak_ptr<scene::node_t>{};
+        }
+    }
+
     /**
      * Return the swap damage if called from overlay or postprocessing
      * effect callbacks or empty region otherwise.
@@ -1060,6 +1801,7 @@ class wf::render_manager::impl
      */
     void paint()
     {
+        WF_TRACE_SCOPE("paint");
         /* Part 1: frame setup: query damage, etc. */
         effects->run_effects(OUTPUT_EFFECT_PRE);
         effects->run_effects(OUTPUT_EFFECT_DAMAGE);
@@ -1080,8 +1822,22 @@ class wf::render_manager::impl
             return;
         }
 
-        /* Part 2: call the renderer, which sets swap_damage and draws the scenegraph */
         update_bound_output(next_frame->buffer);
+        const bool has_sw_cursors = sw_cursors->prepare();
+        if (has_sw_cursors && try_paint_sw_cursors_only(next_frame))
+        {
+            return;
+        }
+
+        if (has_sw_cursors && !sw_cursors->saved_scene_valid)
+        {
+            // The save-under buffer needs to be filled in completely
+            damage_manager->frame_damage |= damage_manager->get_buffer_extents();
+        }
+
+        damage_manager->scene_damaged = false;
+
+        /* Part 2: call the renderer, which sets swap_damage and draws the scenegraph */
         this->swap_damage = start_output_pass(next_frame);
 
         /* Part 3: overlay effects */
@@ -1103,17 +1859,22 @@ class wf::render_manager::impl
 
         effects->run_effects(OUTPUT_EFFECT_PASS_DONE);
 
-        /* Part 5: finalize the scene: postprocessing effects */
-        if (postprocessing->post_effects.size())
+        /* Part 5: finalize the scene: postprocessing effects. Only per-pixel effects can be limited to the
+         * damaged region, any other effect needs to repaint the whole output. */
+        if (postprocessing->post_effects.size() && !postprocessing->is_damage_local())
         {
             swap_damage |= damage_manager->get_buffer_extents();
         }
 
-        postprocessing->run_post_effects();
+        postprocessing->run_post_effects(swap_damage);
 
         /* Part 6: render sw cursors We render software cursors after everything else
          * for consistency with hardware cursor planes */
-        render_sw_cursors(next_frame.get());
+        if (has_sw_cursors)
+        {
+            sw_cursors->save(next_frame->buffer, swap_damage);
+            render_sw_cursors(next_frame.get());
+        }
 
         /* Part 7: finalize frame: swap buffers, send frame_done, etc */
         damage_manager->swap_buffers(std::move(next_frame), swap_damage);
@@ -1123,6 +1884,38 @@ class wf::render_manager::impl
         post_paint();
     }
 
+    /**
+     * If only the software cursors changed since the last frame, restore the damaged area from the
+     * save-under buffer and draw the cursors, without repainting the scene.
+     *
+     * @return Whether the frame was painted.
+     */
+    bool try_paint_sw_cursors_only(
+        std::unique_ptr<swapchain_damage_manager_t::frame_object_t>& next_frame)
+    {
+        // Overlay effects draw on top of the scene each frame, and damage debugging needs a real repaint.
+        if (damage_manager->scene_damaged || !sw_cursors->saved_scene_valid ||
+            effects->effects[OUTPUT_EFFECT_OVERLAY].size() || runtime_config.damage_debug ||
+            runtime_config.no_damage_track)
+        {
+            return false;
+        }
+
+        swap_damage = damage_manager->frame_damage & damage_manager->get_buffer_extents();
+        if (!sw_cursors->restore(next_frame->buffer, swap_damage))
+        {
+            // Fall back to a full repaint of the damaged area
+            sw_cursors->saved_scene_valid = false;
+            return false;
+        }
+
+        damage_manager->swap_buffers(std::move(next_frame), swap_damage);
+        unset_bound_output();
+        swap_damage.clear();
+        post_paint();
+        return true;
+    }
+
     void render_sw_cursors(swapchain_damage_manager_t::frame_object_t *next_frame)
     {
         auto sw_cursor_pass =
@@ -1151,6 +1944,61 @@ class wf::render_manager::impl
     }
 };
 
+const char *scene::scanout_blocker_to_string(scanout_blocker_t reason)
+{
+    switch (reason)
+    {
+      case scanout_blocker_t::NONE:
+        return "none";
+
+      case scanout_blocker_t::INHIBITED:
+        return "inhibited";
+
+      case scanout_blocker_t::EFFECT_HOOKS:
+        return "effect-hooks";
+
+      case scanout_blocker_t::POST_EFFECTS:
+        return "post-effects";
+
+      case scanout_blocker_t::COLOR_TRANSFORM:
+        return "color-transform";
+
+      case scanout_blocker_t::NOT_ALLOWED:
+        return "not-allowed";
+
+      case scanout_blocker_t::DISABLED:
+        return "disabled";
+
+      case scanout_blocker_t::NO_CANDIDATE:
+        return "no-candidate";
+
+      case scanout_blocker_t::OCCLUDED:
+        return "occluded";
+
+      case scanout_blocker_t::TRANSFORMED:
+        return "transformed";
+
+      case scanout_blocker_t::GEOMETRY:
+        return "geometry";
+
+      case scanout_blocker_t::SCALE_TRANSFORM:
+        return "scale-transform";
+
+      case scanout_blocker_t::NOT_OPAQUE:
+        return "not-opaque";
+
+      case scanout_blocker_t::BUFFER_REJECTED:
+        return "buffer-rejected";
+    }
+
+    return "unknown";
+}
+
+void scene::report_scanout_blocker(wf::output_t *output, scanout_blocker_t reason, node_t *node)
+{
+    output->render->pimpl->report_scanout_blocker(reason, node);
+}
+
 scene::direct_scanout scene::try_scanout_from_list(
     const std::vector<scene::render_instance_uptr>& instances,
     wf::output_t *scanout)
@@ -1199,6 +2047,27 @@ void render_manager::schedule_redraw()
     pimpl->damage_manager->schedule_repaint();
 }
 
+void render_manager::set_commit_cadence(const void *source, std::optional<commit_cadence_t> cadence)
+{
+    if (cadence)
+    {
+        pimpl->delay_manager->cadences[source] = *cadence;
+    } else
+    {
+        pimpl->delay_manager->cadences.erase(source);
+    }
+}
+
+output_content_type_t render_manager::get_content_type() const
+{
+    return pimpl->delay_manager->content_type;
+}
+
+const direct_scanout_stats_t& render_manager::get_direct_scanout_stats() const
+{
+    return pimpl->scanout_stats;
+}
+
 void render_manager::add_inhibit(bool add)
 {
     pimpl->add_inhibit(add);
@@ -1224,6 +2093,22 @@ void render_manager::rem_post(post_hook_t *hook)
     pimpl->postprocessing->rem_post(hook);
 }
 
+void render_manager::add_post(post_fragment_effect_t *effect)
+{
+    if (!wf::get_core().is_gles2())
+    {
+        LOGE("Fragment post effects are supported only with the GLES renderer!");
+        return;
+    }
+
+    pimpl->postprocessing->add_post(effect);
+}
+
+void render_manager::rem_post(post_fragment_effect_t *effect)
+{
+    pimpl->postprocessing->rem_post(effect);
+}
+
 wf::region_t render_manager::get_scheduled_damage()
 {
     return pimpl->damage_manager->get_scheduled_damage(get_target_framebuffer());
@@ -1266,6 +2151,25 @@ wf::render_target_t render_manager::get_target_framebuffer() const
     return pimpl->postprocessing->get_target_framebuffer();
 }
 
+void render_manager::set_viewport(std::optional<wlr_fbox> viewport, wlr_scale_filter_mode filter_mode)
+{
+    auto& pp = pimpl->postprocessing;
+    const auto as_tuple = [] (const std::optional<wlr_fbox>& box)
+    {
+        return box ? std::make_tuple(true, box->x, box->y, box->width, box->height) :
+               std::make_tuple(false, 0.0, 0.0, 0.0, 0.0);
+    };
+
+    if ((as_tuple(viewport) == as_tuple(pp->viewport)) && (filter_mode == pp->viewport_filter))
+    {
+        return;
+    }
+
+    pp->viewport = viewport;
+    pp->viewport_filter = filter_mode;
+    pimpl->damage_manager->damage_whole();
+}
+
 void render_manager::set_require_depth_buffer(bool require)
 {
     return pimpl->depth_buffer_manager->set_required(require);
@@ -4,6 +4,7 @@
 #include "wayfire/nonstd/reverse.hpp"
 #include "wayfire/opengl.hpp"
 #include <wayfire/scene-render.hpp>
+#include <wayfire/trace.hpp>
 #include <drm_fourcc.h>
 
 wf::render_buffer_t::render_buffer_t(wlr_buffer *buffer, wf::dimensions_t size)
@@ -283,6 +284,29 @@ wf::render_target_t wf::render_target_t::translated(wf::point_t offset) const
     return copy;
 }
 
+/**
+ * Get the number of framebuffer pixels per logical pixel along each axis, before the subbuffer is applied.
+ *
+ * Without a subbuffer, this is the scale of the target. With a subbuffer, the geometry covers the whole
+ * framebuffer before it is mapped to the subbuffer, while the scale describes the actual magnification of
+ * the contents (for example, when zooming), so the two do not necessarily match.
+ */
+static wf::pointf_t get_geometry_to_buffer_scale(const wf::render_target_t& target)
+{
+    if (!target.subbuffer || (target.geometry.width <= 0) || (target.geometry.height <= 0))
+    {
+        return {target.scale, target.scale};
+    }
+
+    wf::dimensions_t size = target.get_size();
+    if (target.wl_transform & 1)
+    {
+        std::swap(size.width, size.height);
+    }
+
+    return {1.0 * size.width / target.geometry.width, 1.0 * size.height / target.geometry.height};
+}
+
 wlr_fbox wf::render_target_t::framebuffer_box_from_geometry_box(wlr_fbox box) const
 {
     /* Step 1: Make relative to the framebuffer */
@@ -290,7 +314,11 @@ wlr_fbox wf::render_target_t::framebuffer_box_from_geometry_box(wlr_fbox box) co
     box.y -= this->geometry.y;
 
     /* Step 2: Apply scale to box */
-    box = box * scale;
+    const auto box_scale = get_geometry_to_buffer_scale(*this);
+    box.x      *= box_scale.x;
+    box.width  *= box_scale.x;
+    box.y      *= box_scale.y;
+    box.height *= box_scale.y;
 
     /* Step 3: rotate */
     wf::dimensions_t size = get_size();
@@ -345,9 +373,13 @@ wlr_fbox wf::render_target_t::geometry_fbox_from_framebuffer_box(wlr_fbox fb_box
     wlr_fbox_transform(&result, &fb_box, (wl_output_transform)wl_transform,
         current_fb_dimensions.width, current_fb_dimensions.height);
 
-    if (scale != 0.0f)
+    const auto box_scale = get_geometry_to_buffer_scale(*this);
+    if ((box_scale.x != 0.0) && (box_scale.y != 0.0))
     {
-        result = result * (1.0 / scale);
+        result.x      /= box_scale.x;
+        result.width  /= box_scale.x;
+        result.y      /= box_scale.y;
+        result.height /= box_scale.y;
     } else
     {
         LOGE("Render target scale is zero, cannot invert framebuffer box!");
@@ -392,6 +424,7 @@ wf::region_t wf::render_pass_t::run(const wf::render_pass_params_t& params)
 
 wf::region_t wf::render_pass_t::run_partial()
 {
+    WF_TRACE_SCOPE("render-pass");
     auto accumulated_damage = params.damage;
     if (params.flags & RPASS_EMIT_SIGNALS)
     {
@@ -508,7 +541,8 @@ void wf::render_pass_t::add_texture(const wf::texture_t& texture, const wf::rend
     // but only for integer scale.
     const auto preferred_filter = ((adjusted_target.scale - floor(adjusted_target.scale)) < 0.001) ?
         WLR_SCALE_FILTER_NEAREST : WLR_SCALE_FILTER_BILINEAR;
-    opts.filter_mode = texture.filter_mode.value_or(preferred_filter);
+    opts.filter_mode =
+        texture.filter_mode.value_or(adjusted_target.filter_mode.value_or(preferred_filter));
     opts.transform   = wlr_output_transform_compose(wlr_output_transform_invert(texture.transform),
         adjusted_target.wl_transform);
     opts.clip    = fb_damage.to_pixman();
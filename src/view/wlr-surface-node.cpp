@@ -6,13 +6,18 @@
 #include "wayfire/scene.hpp"
 #include "wlr-surface-pointer-interaction.hpp"
 #include "wlr-surface-touch-interaction.cpp"
+#include "../core/commit-timing.hpp"
 #include "wayfire/output-layout.hpp"
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 #include <wayfire/signal-provider.hpp>
 #include <wlr/util/box.h>
+#include <drm_fourcc.h>
 
 wf::scene::surface_state_t::surface_state_t(surface_state_t&& other)
 {
@@ -96,6 +101,32 @@ wf::scene::surface_state_t::~surface_state_t()
     }
 }
 
+/**
+ * Check whether the buffer is in a format without an alpha channel, which means that it is opaque
+ * regardless of the opaque region the client has set (video players often do not set one).
+ */
+static bool is_buffer_format_opaque(wlr_buffer *buffer)
+{
+    static const std::vector<uint32_t> opaque_formats = {
+        DRM_FORMAT_XRGB8888, DRM_FORMAT_XBGR8888, DRM_FORMAT_RGBX8888, DRM_FORMAT_BGRX8888,
+        DRM_FORMAT_XRGB2101010, DRM_FORMAT_XBGR2101010, DRM_FORMAT_RGB565,
+        DRM_FORMAT_NV12, DRM_FORMAT_NV21, DRM_FORMAT_P010, DRM_FORMAT_YUV420, DRM_FORMAT_YVU420,
+    };
+
+    uint32_t format = DRM_FORMAT_INVALID;
+    wlr_dmabuf_attributes dmabuf;
+    wlr_shm_attributes shm;
+    if (wlr_buffer_get_dmabuf(buffer, &dmabuf))
+    {
+        format = dmabuf.format;
+    } else if (wlr_buffer_get_shm(buffer, &shm))
+    {
+        format = shm.format;
+    }
+
+    return std::find(opaque_formats.begin(), opaque_formats.end(), format) != opaque_formats.end();
+}
+
 wf::scene::wlr_surface_node_t::wlr_surface_node_t(wlr_surface *surface, bool autocommit) :
     node_t(false), autocommit(autocommit)
 {
@@ -111,10 +142,16 @@ wf::scene::wlr_surface_node_t::wlr_surface_node_t(wlr_surface *surface, bool aut
 
         on_surface_commit.disconnect();
         on_surface_destroyed.disconnect();
+        stop_frame_throttling();
     });
 
     this->on_surface_commit.set_callback([=] (void*)
     {
+        if ((this->surface->current.committed & WLR_SURFACE_STATE_BUFFER) && this->surface->buffer)
+        {
+            record_buffer_commit();
+        }
+
         if (this->autocommit)
         {
             apply_current_surface_state();
@@ -129,6 +166,7 @@ wf::scene::wlr_surface_node_t::wlr_surface_node_t(wlr_surface *surface, bool aut
     on_surface_destroyed.connect(&surface->events.destroy);
     on_surface_commit.connect(&surface->events.commit);
     send_frame_done(false);
+    update_frame_throttling();
 
     current_state.merge_state(surface);
 
@@ -136,6 +174,7 @@ wf::scene::wlr_surface_node_t::wlr_surface_node_t(wlr_surface *surface, bool aut
     {
         visibility.erase(ev->output);
         pending_visibility_delta.erase(ev->output);
+        visible_instances.erase(ev->output);
     });
     wf::get_core().output_layout->connect(&on_output_remove);
 }
@@ -149,6 +188,19 @@ void wf::scene::wlr_surface_node_t::apply_state(surface_state_t&& state)
         state.accumulated_damage |= wf::construct_box({0, 0}, state.size);
     }
 
+    if (pending_buffer_commits > 0)
+    {
+        if (!visible_instances.empty())
+        {
+            // Buffers committed, but replaced before they could be applied or shown
+            presentation_stats.dropped += pending_buffer_commits - 1 + (current_buffer_presented ? 0 : 1);
+        }
+
+        pending_buffer_commits   = 0;
+        current_buffer_presented = false;
+        current_buffer_commit_us = last_buffer_commit_us;
+    }
+
     this->current_state = std::move(state);
     wf::scene::damage_node(this, current_state.accumulated_damage);
     if (size_changed)
@@ -235,6 +287,183 @@ void wf::scene::wlr_surface_node_t::send_frame_done(bool delay_until_vblank)
     }
 }
 
+/**
+ * The frame rate of hidden surfaces. The option is read once for all surface nodes, and the timers of the
+ * hidden surfaces are re-armed when it changes.
+ */
+struct wf::scene::wlr_surface_node_t::hidden_frame_rate_t : public wf::custom_data_t
+{
+    wf::option_wrapper_t<int> rate{"core/hidden_surface_frame_rate"};
+    std::set<wlr_surface_node_t*> throttled;
+
+    hidden_frame_rate_t()
+    {
+        rate.set_callback([=] ()
+        {
+            for (auto node : throttled)
+            {
+                node->hidden_frame_timer.disconnect();
+                node->update_frame_throttling();
+            }
+        });
+    }
+
+    /** @return The interval between frames of hidden surfaces, or 0 if they may not draw at all. */
+    uint32_t get_interval_ms()
+    {
+        // Rates above 1000 would round down to 0, which would stall the surfaces instead.
+        return (rate <= 0) ? 0 : std::max(1, 1000 / rate);
+    }
+};
+
+wf::scene::wlr_surface_node_t::~wlr_surface_node_t()
+{
+    stop_frame_throttling();
+}
+
+void wf::scene::wlr_surface_node_t::set_instance_visible(wf::output_t *output, bool visible)
+{
+    const bool was_hidden = visible_instances.empty();
+    int& count = visible_instances[output];
+    count += (visible ? 1 : -1);
+    if (count <= 0)
+    {
+        visible_instances.erase(output);
+        output->render->set_commit_cadence(this, std::nullopt);
+    } else if (visible && (count == 1))
+    {
+        output->render->set_commit_cadence(this, get_commit_cadence());
+    }
+
+    if (was_hidden && !visible_instances.empty())
+    {
+        // The surface just became visible, let it draw immediately instead of waiting for the next frame.
+        send_frame_done(false);
+    }
+
+    update_frame_throttling();
+}
+
+void wf::scene::wlr_surface_node_t::update_frame_throttling()
+{
+    if (!visible_instances.empty() || !surface)
+    {
+        stop_frame_throttling();
+        return;
+    }
+
+    auto hidden_frame_rate = wf::get_core().get_data_safe<hidden_frame_rate_t>();
+    hidden_frame_rate->throttled.insert(this);
+    frame_throttled = true;
+
+    const uint32_t interval_ms = hidden_frame_rate->get_interval_ms();
+    if (hidden_frame_timer.is_connected() || (interval_ms == 0))
+    {
+        return;
+    }
+
+    hidden_frame_timer.set_timeout(interval_ms, [=] ()
+    {
+        if (surface && !wl_list_empty(&surface->current.frame_callback_list))
+        {
+            send_frame_done(false);
+        }
+
+        return true;
+    });
+}
+
+void wf::scene::wlr_surface_node_t::stop_frame_throttling()
+{
+    hidden_frame_timer.disconnect();
+    if (frame_throttled)
+    {
+        wf::get_core().get_data_safe<hidden_frame_rate_t>()->throttled.erase(this);
+        frame_throttled = false;
+    }
+}
+
+void wf::scene::wlr_surface_node_t::record_buffer_commit()
+{
+    const int64_t now = wf::get_current_time_us();
+    ++presentation_stats.commits;
+    ++pending_buffer_commits;
+    if (last_buffer_commit_us >= 0)
+    {
+        commit_intervals_us[num_commit_intervals % CADENCE_SAMPLES] = now - last_buffer_commit_us;
+        ++num_commit_intervals;
+    }
+
+    last_buffer_commit_us = now;
+    update_cadence_hints(get_commit_cadence());
+}
+
+std::optional<wf::commit_cadence_t> wf::scene::wlr_surface_node_t::get_commit_cadence() const
+{
+    // Ignore surfaces updating faster than 250Hz or slower than 10Hz, as well as surfaces which have not
+    // committed for a while.
+    constexpr int64_t min_period_us = 4'000;
+    constexpr int64_t max_period_us = 100'000;
+
+    if ((num_commit_intervals < CADENCE_SAMPLES / 2) || (last_buffer_commit_us < 0))
+    {
+        return {};
+    }
+
+    const size_t n = std::min(num_commit_intervals, CADENCE_SAMPLES);
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += commit_intervals_us[i];
+    }
+
+    const int64_t period = sum / n;
+    if ((period < min_period_us) || (period > max_period_us) ||
+        (wf::get_current_time_us() - last_buffer_commit_us > 2 * period))
+    {
+        return {};
+    }
+
+    // The cadence is stable if no interval deviates by more than 15% from the average.
+    for (size_t i = 0; i < n; i++)
+    {
+        if (std::abs(commit_intervals_us[i] - period) * 100 > period * 15)
+        {
+            return {};
+        }
+    }
+
+    return wf::commit_cadence_t{
+        .last_commit_us = last_buffer_commit_us,
+        .period_us = period,
+    };
+}
+
+void wf::scene::wlr_surface_node_t::update_cadence_hints(std::optional<wf::commit_cadence_t> cadence)
+{
+    for (auto& [output, _] : visible_instances)
+    {
+        output->render->set_commit_cadence(this, cadence);
+    }
+}
+
+const wf::scene::surface_presentation_stats_t& wf::scene::wlr_surface_node_t::get_presentation_stats() const
+{
+    return presentation_stats;
+}
+
+void wf::scene::wlr_surface_node_t::mark_presented()
+{
+    if (current_buffer_presented || (current_buffer_commit_us < 0))
+    {
+        return;
+    }
+
+    current_buffer_presented = true;
+    ++presentation_stats.presented;
+    presentation_stats.total_latency_us += wf::get_current_time_us() - current_buffer_commit_us;
+}
+
 class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public render_instance_t
 {
     std::shared_ptr<wlr_surface_node_t> self;
@@ -246,6 +475,27 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
     wf::output_t *visible_on;
     damage_callback push_damage;
     wf::region_t last_visibility;
+    // The output on which compute_visibility() last found us visible, if any
+    wf::output_t *visible_output = nullptr;
+
+    void set_visible(wf::output_t *output)
+    {
+        if (visible_output == output)
+        {
+            return;
+        }
+
+        if (visible_output)
+        {
+            self->set_instance_visible(visible_output, false);
+        }
+
+        visible_output = output;
+        if (visible_output)
+        {
+            self->set_instance_visible(visible_output, true);
+        }
+    }
 
     wf::signal::connection_t<node_damage_signal> on_surface_damage =
         [=] (node_damage_signal *data)
@@ -296,6 +546,8 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
         {
             self->handle_leave(visible_on);
         }
+
+        set_visible(nullptr);
     }
 
     void schedule_instructions(std::vector<render_instruction_t>& instructions,
@@ -326,6 +578,7 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
         }
 
         data.pass->add_texture(*self->to_texture(), data.target, self->get_bounding_box(), data.damage);
+        self->mark_presented();
     }
 
     void presentation_feedback(wf::output_t *output) override
@@ -345,6 +598,7 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
 
         if (self->get_bounding_box() != output->get_relative_geometry())
         {
+            report_scanout_blocker(output, scanout_blocker_t::GEOMETRY, self.get());
             return direct_scanout::OCCLUSION;
         }
 
@@ -353,14 +607,19 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
         if ((wlr_surf->current.scale != output->handle->scale) ||
             (wlr_surf->current.transform != output->handle->transform))
         {
+            report_scanout_blocker(output, scanout_blocker_t::SCALE_TRANSFORM, self.get());
             return direct_scanout::OCCLUSION;
         }
 
-        // Finally, the opaque region must be the full surface.
+        // Finally, the opaque region must be the full surface. When the output is showing a video, a
+        // buffer format without alpha is good enough, because video players often do not set an opaque
+        // region.
         wf::region_t non_opaque = output->get_relative_geometry();
         non_opaque ^= wf::region_t{&wlr_surf->opaque_region};
-        if (!non_opaque.empty())
+        const bool eager = (output->render->get_content_type() == wf::output_content_type_t::VIDEO);
+        if (!non_opaque.empty() && !(eager && is_buffer_format_opaque(&wlr_surf->buffer->base)))
         {
+            report_scanout_blocker(output, scanout_blocker_t::NOT_OPAQUE, self.get());
             return direct_scanout::OCCLUSION;
         }
 
@@ -372,10 +631,12 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
         if (wlr_output_commit_state(output->handle, &state))
         {
             wlr_output_state_finish(&state);
+            self->mark_presented();
             return direct_scanout::SUCCESS;
         } else
         {
             wlr_output_state_finish(&state);
+            report_scanout_blocker(output, scanout_blocker_t::BUFFER_REJECTED, self.get());
             return direct_scanout::OCCLUSION;
         }
     }
@@ -395,7 +656,9 @@ class wf::scene::wlr_surface_node_t::wlr_surface_render_instance_t : public rend
             "workarounds/enable_opaque_region_damage_optimizations"
         };
 
-        if (!(visible & our_box).empty())
+        const bool is_visible_now = !(visible & our_box).empty();
+        set_visible(is_visible_now ? output : nullptr);
+        if (is_visible_now)
         {
             // We are visible on the given output => send wl_surface.frame on output frame, so that clients
             // can draw the next frame.
@@ -496,5 +759,10 @@ void wf::scene::wlr_surface_node_t::update_pending_outputs()
         wlr_surface_set_preferred_buffer_scale(surface, max_scale);
     }
 
+    if (surface && wf::get_core_impl().commit_timing)
+    {
+        wf::get_core_impl().commit_timing->update_output(surface);
+    }
+
     pending_visibility_delta.clear();
 }
@@ -4,6 +4,9 @@
  * Utilities for logging to a selected output stream.
  */
 #include <wayfire/util/stringify.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 
 namespace wf
 {
@@ -29,6 +32,15 @@ enum color_mode_t
     LOG_COLOR_MODE_OFF = 2,
 };
 
+enum output_format_t
+{
+    /** Human-readable lines, see log_plain() */
+    LOG_FORMAT_TEXT = 1,
+    /** One JSON object per line, with the fields level, time, source, line
+     *  and message, for consumption by log collectors */
+    LOG_FORMAT_JSON = 2,
+};
+
 /**
  * (Re-)Initialize the logging system.
  * The log output after this call will go to the indicated output stream.
@@ -44,6 +56,47 @@ enum color_mode_t
 void initialize_logging(std::ostream& output_stream, log_level_t minimum_level,
     color_mode_t color_mode, std::string strip_path = "");
 
+/**
+ * Set the format of the log output. The default is LOG_FORMAT_TEXT.
+ */
+void set_output_format(output_format_t format);
+
+/**
+ * Switch to asynchronous logging, or back to synchronous logging if
+ * @capacity is 0.
+ *
+ * In asynchronous mode, messages are still formatted by the logging thread,
+ * but then queued in a lock-free buffer of @capacity messages, which is
+ * written to the output stream by a background thread. If the buffer is
+ * full, messages are dropped. The number of dropped messages is reported in
+ * the log itself and by get_dropped_messages().
+ */
+void enable_async_logging(size_t capacity);
+
+/**
+ * Block until all messages logged so far have been written to the output
+ * stream.
+ */
+void flush_logging();
+
+/**
+ * Wait at most @timeout until all messages logged so far have been written.
+ *
+ * Unlike flush_logging(), this never waits for a lock, so it can be used in
+ * a handler for fatal signals, even if the crash happened in the writer
+ * thread or while the crashed thread held a lock of the logger. In
+ * synchronous mode, it does nothing.
+ *
+ * @return Whether all messages have been written.
+ */
+bool flush_logging(std::chrono::milliseconds timeout);
+
+/**
+ * @return The number of messages dropped since asynchronous logging was
+ *  enabled.
+ */
+uint64_t get_dropped_messages();
+
 /**
  * Log a plain message to the given output stream.
  * The output format is:
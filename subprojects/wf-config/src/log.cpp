@@ -5,6 +5,12 @@
 #include <map>
 #include <chrono>
 #include <iomanip>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <time.h>
 
 template<>
 std::string wf::log::to_string<void*>(void *arg)
@@ -25,6 +31,252 @@ std::string wf::log::to_string(bool arg)
     return arg ? "true" : "false";
 }
 
+namespace
+{
+/**
+ * A bounded multi-producer, single-consumer queue of formatted log lines,
+ * after D. Vyukov's bounded MPMC queue. Pushing never blocks or locks, it
+ * fails instead if the queue is full.
+ */
+class log_ring_t
+{
+  public:
+    log_ring_t(size_t min_capacity)
+    {
+        size_t capacity = 2;
+        while (capacity < min_capacity)
+        {
+            capacity *= 2;
+        }
+
+        mask  = capacity - 1;
+        slots = std::make_unique<slot_t[]>(capacity);
+        for (size_t i = 0; i < capacity; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool try_push(std::string&& line)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        slot_t *slot;
+        while (true)
+        {
+            slot = &slots[pos & mask];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            } else if (diff < 0)
+            {
+                return false;
+            } else
+            {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->line = std::move(line);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* May be called only from a single thread at a time. */
+    bool try_pop(std::string& line)
+    {
+        size_t pos   = tail.load(std::memory_order_relaxed);
+        slot_t *slot = &slots[pos & mask];
+        size_t seq   = slot->sequence.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+        {
+            return false;
+        }
+
+        line = std::move(slot->line);
+        slot->line.clear();
+        slot->sequence.store(pos + mask + 1, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+  private:
+    struct slot_t
+    {
+        std::atomic<size_t> sequence;
+        std::string line;
+    };
+
+    std::unique_ptr<slot_t[]> slots;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+/**
+ * Writes the lines queued by any thread to the output stream on a
+ * background thread, so that logging never waits for the output.
+ */
+class async_writer_t
+{
+  public:
+    async_writer_t(std::ostream& out, size_t capacity) : out(out), ring(capacity)
+    {
+        thread = std::thread([=] () { run(); });
+    }
+
+    ~async_writer_t()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wake_cv.notify_one();
+        thread.join();
+    }
+
+    void push(std::string&& line)
+    {
+        if (!ring.try_push(std::move(line)))
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Sequentially consistent, like the writer's store of `sleeping` and
+        // load of `pushed`: either we see the flag or it sees the new line.
+        pushed.fetch_add(1);
+        if (sleeping.load())
+        {
+            // The writer checks `pushed` and starts waiting with the mutex
+            // held, so taking it here ensures the notification is not sent in
+            // between and missed.
+            std::lock_guard<std::mutex> lock(mutex);
+            wake_cv.notify_one();
+        }
+    }
+
+    /* Block until all lines queued so far have been written. */
+    void flush()
+    {
+        uint64_t target = pushed.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex);
+        wake_cv.notify_one();
+        flushed_cv.wait(lock, [&] { return written >= target; });
+    }
+
+    /* Wait for the lines queued so far without locking, see flush_logging(timeout). */
+    bool flush_without_locking(std::chrono::milliseconds timeout)
+    {
+        const uint64_t target = pushed.load(std::memory_order_acquire);
+        const auto deadline   = std::chrono::steady_clock::now() + timeout;
+        while (written.load() < target)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+
+            // The writer checks for new lines at least every 100ms even
+            // without a wakeup. nanosleep() is async-signal-safe.
+            timespec pause = {0, 1000000};
+            nanosleep(&pause, nullptr);
+        }
+
+        return true;
+    }
+
+    uint64_t get_dropped() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::ostream& out;
+    log_ring_t ring;
+    std::thread thread;
+
+    std::mutex mutex;
+    std::condition_variable wake_cv;
+    std::condition_variable flushed_cv;
+    std::atomic<bool> sleeping{false};
+    bool stopping = false;
+
+    std::atomic<uint64_t> pushed{0};
+    std::atomic<uint64_t> dropped{0};
+    // Modified with the mutex held, but may be read without it.
+    std::atomic<uint64_t> written{0};
+    uint64_t reported_dropped = 0;
+
+    /* Write all queued lines, @return how many. */
+    uint64_t drain()
+    {
+        uint64_t count = 0;
+        std::string line;
+        while (ring.try_pop(line))
+        {
+            out << line << '\n';
+            ++count;
+        }
+
+        uint64_t now_dropped = get_dropped();
+        if (now_dropped != reported_dropped)
+        {
+            out << "WW - " << (now_dropped - reported_dropped) <<
+                " log messages dropped because the log buffer was full\n";
+            reported_dropped = now_dropped;
+        }
+
+        if (count > 0)
+        {
+            out.flush();
+        }
+
+        return count;
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            uint64_t count = drain();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            written += count;
+            flushed_cv.notify_all();
+            if (stopping)
+            {
+                lock.unlock();
+                drain();
+                return;
+            }
+
+            if (count > 0)
+            {
+                continue;
+            }
+
+            // Producers check the flag after queueing, so either they see it
+            // and wake us, or we see their line when checking again. The
+            // timeout is just a safety net.
+            sleeping.store(true);
+            if (pushed.load() == written)
+            {
+                wake_cv.wait_for(lock, std::chrono::milliseconds(100));
+            }
+
+            sleeping.store(false);
+        }
+    }
+};
+}
+
 /**
  * A singleton to hold log configuration.
  */
@@ -34,10 +286,15 @@ struct log_global_t
 
     wf::log::log_level_t level = wf::log::LOG_LEVEL_INFO;
     wf::log::color_mode_t color_mode = wf::log::LOG_COLOR_MODE_OFF;
+    wf::log::output_format_t format  = wf::log::LOG_FORMAT_TEXT;
     std::string strip_path = "";
 
     std::string clear_color = "";
 
+    /* Capacity of the async log buffer, 0 if logging synchronously. */
+    size_t async_capacity = 0;
+    std::unique_ptr<async_writer_t> async_writer;
+
     static log_global_t& get()
     {
         static log_global_t instance;
@@ -65,6 +322,54 @@ void wf::log::initialize_logging(std::ostream& output_stream,
     {
         state.clear_color = "";
     }
+
+    if (state.async_capacity > 0)
+    {
+        /* Write the remaining lines to the old stream and continue with the new one. */
+        state.async_writer.reset();
+        state.async_writer = std::make_unique<async_writer_t>(
+            state.out.get(), state.async_capacity);
+    }
+}
+
+void wf::log::set_output_format(output_format_t format)
+{
+    log_global_t::get().format = format;
+}
+
+void wf::log::enable_async_logging(size_t capacity)
+{
+    auto& state = log_global_t::get();
+    state.async_writer.reset();
+    state.async_capacity = capacity;
+    if (capacity > 0)
+    {
+        state.async_writer = std::make_unique<async_writer_t>(state.out.get(), capacity);
+    }
+}
+
+bool wf::log::flush_logging(std::chrono::milliseconds timeout)
+{
+    auto& state = log_global_t::get();
+    return !state.async_writer || state.async_writer->flush_without_locking(timeout);
+}
+
+void wf::log::flush_logging()
+{
+    auto& state = log_global_t::get();
+    if (state.async_writer)
+    {
+        state.async_writer->flush();
+    } else
+    {
+        state.out.get().flush();
+    }
+}
+
+uint64_t wf::log::get_dropped_messages()
+{
+    auto& state = log_global_t::get();
+    return state.async_writer ? state.async_writer->get_dropped() : 0;
 }
 
 /** Get the line prefix for the given log level */
@@ -131,6 +436,47 @@ static std::string strip_path(const std::string& path)
     return path;
 }
 
+/** Escape the given string for use in a JSON string literal. */
+static std::string escape_json(const std::string& str)
+{
+    std::string result;
+    result.reserve(str.size());
+    for (unsigned char c : str)
+    {
+        switch (c)
+        {
+          case '"':
+            result += "\\\"";
+            break;
+
+          case '\\':
+            result += "\\\\";
+            break;
+
+          case '\n':
+            result += "\\n";
+            break;
+
+          case '\t':
+            result += "\\t";
+            break;
+
+          default:
+            if (c < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                result += buf;
+            } else
+            {
+                result += c;
+            }
+        }
+    }
+
+    return result;
+}
+
 /**
  * Log a plain message to the given output stream.
  * The output format is:
@@ -152,17 +498,41 @@ void wf::log::log_plain(log_level_t level, const std::string& contents,
         return;
     }
 
-    std::string path_info;
-    if (!source.empty())
+    std::string line;
+    if (state.format == LOG_FORMAT_JSON)
+    {
+        static const char *level_names[] = {"debug", "info", "warn", "error"};
+        line = wf::log::detail::format_concat(
+            "{\"level\":\"", level_names[level],
+            "\",\"time\":\"", get_formatted_date_time(), "\"");
+        if (!source.empty())
+        {
+            line += wf::log::detail::format_concat(
+                ",\"source\":\"", escape_json(strip_path(source)),
+                "\",\"line\":", line_nr);
+        }
+
+        line += ",\"message\":\"" + escape_json(contents) + "\"}";
+    } else
     {
-        path_info = wf::log::detail::format_concat(
-            "[", strip_path(source), ":", line_nr, "] ");
+        std::string path_info;
+        if (!source.empty())
+        {
+            path_info = wf::log::detail::format_concat(
+                "[", strip_path(source), ":", line_nr, "] ");
+        }
+
+        line = wf::log::detail::format_concat(
+            get_level_prefix(level), " ",
+            get_formatted_date_time(),
+            " - ", path_info, contents, state.clear_color);
     }
 
-    state.out.get() <<
-        wf::log::detail::format_concat(
-        get_level_prefix(level), " ",
-        get_formatted_date_time(),
-        " - ", path_info, contents) <<
-        state.clear_color << std::endl;
+    if (state.async_writer)
+    {
+        state.async_writer->push(std::move(line));
+    } else
+    {
+        state.out.get() << line << std::endl;
+    }
 }
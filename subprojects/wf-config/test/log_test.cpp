@@ -121,3 +121,66 @@ TEST_CASE("wf::log::log_plain(color_on)")
     LOGE("test");
     check_line("\033[1;31m");
 }
+
+TEST_CASE("wf::log::enable_async_logging()")
+{
+    using namespace wf::log;
+    std::stringstream out;
+    initialize_logging(out, LOG_LEVEL_DEBUG, LOG_COLOR_MODE_OFF, "/test/strip/");
+    enable_async_logging(1024);
+
+    for (int i = 0; i < 100; i++)
+    {
+        log_plain(LOG_LEVEL_INFO, "line " + std::to_string(i), "/test/strip/main.cpp", i);
+    }
+
+    flush_logging();
+    CHECK(get_dropped_messages() == 0);
+
+    for (int i = 0; i < 100; i++)
+    {
+        std::string line;
+        std::getline(out, line);
+        REQUIRE(line.length() >= 2 + 24);
+        line.erase(2, 24);
+        CHECK(line == "II - [main.cpp:" + std::to_string(i) + "] line " + std::to_string(i));
+    }
+
+    enable_async_logging(0);
+}
+
+TEST_CASE("wf::log::flush_logging(timeout)")
+{
+    using namespace wf::log;
+    std::stringstream out;
+    initialize_logging(out, LOG_LEVEL_DEBUG, LOG_COLOR_MODE_OFF, "/test/strip/");
+    CHECK(flush_logging(std::chrono::milliseconds(0)));
+
+    enable_async_logging(16);
+    log_plain(LOG_LEVEL_INFO, "before crash", "/test/strip/main.cpp", 1);
+    CHECK(flush_logging(std::chrono::seconds(5)));
+
+    std::string line;
+    std::getline(out, line);
+    CHECK(line.find("before crash") != std::string::npos);
+    enable_async_logging(0);
+}
+
+TEST_CASE("wf::log::set_output_format(json)")
+{
+    using namespace wf::log;
+    std::stringstream out;
+    initialize_logging(out, LOG_LEVEL_DEBUG, LOG_COLOR_MODE_ON, "/test/strip/");
+    set_output_format(LOG_FORMAT_JSON);
+
+    log_plain(LOG_LEVEL_WARN, "say \"hi\"", "/test/strip/main.cpp", 5);
+    std::string line;
+    std::getline(out, line);
+
+    auto time_start = line.find(",\"time\":\"");
+    REQUIRE(time_start != std::string::npos);
+    line.erase(time_start, 9 + 23 + 1);
+    CHECK(line == "{\"level\":\"warn\",\"source\":\"main.cpp\",\"line\":5,\"message\":\"say \\\"hi\\\"\"}");
+
+    set_output_format(LOG_FORMAT_TEXT);
+}
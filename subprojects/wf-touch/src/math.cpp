@@ -102,6 +102,12 @@ double wf::touch::finger_t::get_incorrect_drag_distance(uint32_t direction) cons
 
 double wf::touch::gesture_state_t::get_pinch_scale() const
 {
+    sync_derived();
+    if (derived.pinch_scale)
+    {
+        return *derived.pinch_scale;
+    }
+
     auto center = get_center();
     double old_dist = 0;
     double new_dist = 0;
@@ -114,11 +120,18 @@ double wf::touch::gesture_state_t::get_pinch_scale() const
 
     old_dist /= fingers.size();
     new_dist /= fingers.size();
-    return new_dist / old_dist;
+    derived.pinch_scale = new_dist / old_dist;
+    return *derived.pinch_scale;
 }
 
 double wf::touch::gesture_state_t::get_rotation_angle() const
 {
+    sync_derived();
+    if (derived.rotation_angle)
+    {
+        return *derived.rotation_angle;
+    }
+
     auto center = get_center();
 
     double angle_sum = 0;
@@ -130,5 +143,6 @@ double wf::touch::gesture_state_t::get_rotation_angle() const
     }
 
     angle_sum /= fingers.size();
+    derived.rotation_angle = angle_sum;
     return angle_sum;
 }
@@ -1,4 +1,6 @@
 #include <wayfire/touch/touch.hpp>
+#include <algorithm>
+#include <utility>
 
 using namespace wf::touch;
 
@@ -7,25 +9,158 @@ point_t wf::touch::finger_t::delta() const
     return this->current - this->origin;
 }
 
-finger_t wf::touch::gesture_state_t::get_center() const
+wf::touch::finger_map_t::iterator wf::touch::finger_map_t::begin()
 {
-    finger_t center;
-    center.origin = {0, 0};
-    center.current = {0, 0};
+    ++version;
+    return slots.data();
+}
+
+wf::touch::finger_map_t::iterator wf::touch::finger_map_t::end()
+{
+    return slots.data() + nr_fingers;
+}
+
+wf::touch::finger_map_t::const_iterator wf::touch::finger_map_t::begin() const
+{
+    return slots.data();
+}
+
+wf::touch::finger_map_t::const_iterator wf::touch::finger_map_t::end() const
+{
+    return slots.data() + nr_fingers;
+}
+
+size_t wf::touch::finger_map_t::size() const
+{
+    return nr_fingers;
+}
+
+bool wf::touch::finger_map_t::empty() const
+{
+    return nr_fingers == 0;
+}
+
+size_t wf::touch::finger_map_t::count(int id) const
+{
+    return find(id) != end() ? 1 : 0;
+}
 
+wf::touch::finger_map_t::iterator wf::touch::finger_map_t::find(int id)
+{
+    ++version;
+    return const_cast<iterator>(std::as_const(*this).find(id));
+}
+
+wf::touch::finger_map_t::const_iterator wf::touch::finger_map_t::find(int id) const
+{
+    for (auto it = begin(); it != end(); ++it)
+    {
+        if (it->first == id)
+        {
+            return it;
+        }
+    }
+
+    return end();
+}
+
+finger_t& wf::touch::finger_map_t::operator [](int id)
+{
+    ++version;
+    size_t pos = 0;
+    while ((pos < nr_fingers) && (slots[pos].first < id))
+    {
+        ++pos;
+    }
+
+    if ((pos < nr_fingers) && (slots[pos].first == id))
+    {
+        return slots[pos].second;
+    }
+
+    if (nr_fingers == MAX_FINGERS)
+    {
+        overflow = finger_t{};
+        return overflow;
+    }
+
+    std::move_backward(slots.begin() + pos, slots.begin() + nr_fingers, slots.begin() + nr_fingers + 1);
+    slots[pos] = {id, finger_t{}};
+    ++nr_fingers;
+    return slots[pos].second;
+}
+
+size_t wf::touch::finger_map_t::erase(int id)
+{
+    ++version;
+    auto it = const_cast<iterator>(std::as_const(*this).find(id));
+    if (it == end())
+    {
+        return 0;
+    }
+
+    std::move(it + 1, end(), it);
+    --nr_fingers;
+    return 1;
+}
+
+void wf::touch::finger_map_t::clear()
+{
+    ++version;
+    nr_fingers = 0;
+}
+
+uint64_t wf::touch::finger_map_t::get_version() const
+{
+    return version;
+}
+
+void wf::touch::gesture_state_t::sync_derived() const
+{
+    if (derived.version == fingers.get_version())
+    {
+        return;
+    }
+
+    derived = derived_t{};
     for (auto& f : this->fingers)
     {
-        center.origin += f.second.origin;
-        center.current += f.second.current;
+        derived.origin_sum  += f.second.origin;
+        derived.current_sum += f.second.current;
     }
 
-    center.origin /= this->fingers.size();
-    center.current /= this->fingers.size();
+    derived.version = fingers.get_version();
+}
+
+void wf::touch::gesture_state_t::add_finger_to_derived(int id, double sign)
+{
+    auto it = std::as_const(fingers).find(id);
+    if (it != std::as_const(fingers).end())
+    {
+        derived.origin_sum  += sign * it->second.origin;
+        derived.current_sum += sign * it->second.current;
+    }
+}
+
+finger_t wf::touch::gesture_state_t::get_center() const
+{
+    sync_derived();
+
+    finger_t center;
+    center.origin  = derived.origin_sum / (double)this->fingers.size();
+    center.current = derived.current_sum / (double)this->fingers.size();
     return center;
 }
 
 void wf::touch::gesture_state_t::update(const gesture_event_t& event)
 {
+    // Keep the derived values up to date incrementally, unless they are already stale anyway.
+    const bool incremental = (derived.version == fingers.get_version());
+    if (incremental)
+    {
+        add_finger_to_derived(event.finger, -1);
+    }
+
     switch (event.type)
     {
       case EVENT_TYPE_TOUCH_DOWN:
@@ -40,14 +175,31 @@ void wf::touch::gesture_state_t::update(const gesture_event_t& event)
       default:
         break;
     }
+
+    if (incremental)
+    {
+        add_finger_to_derived(event.finger, 1);
+        derived.pinch_scale.reset();
+        derived.rotation_angle.reset();
+        derived.version = fingers.get_version();
+    }
 }
 
 void wf::touch::gesture_state_t::reset_origin()
 {
+    const bool incremental = (derived.version == fingers.get_version());
     for (auto& f : fingers)
     {
         f.second.origin = f.second.current;
     }
+
+    if (incremental)
+    {
+        derived.origin_sum = derived.current_sum;
+        derived.pinch_scale.reset();
+        derived.rotation_angle.reset();
+        derived.version = fingers.get_version();
+    }
 }
 
 wf::touch::gesture_action_t& wf::touch::gesture_action_t::set_duration(uint32_t duration)
@@ -115,7 +267,6 @@ class wf::touch::gesture_t::impl
 
         auto& idx = current_action;
 
-        auto old_finger_state = finger_state;
         finger_state.update(event);
 
         auto next_action = [&] () -> bool
@@ -136,6 +136,68 @@ TEST_CASE("gesture_state_t::reset_origin")
     compare_finger(state.fingers[0], finger_2p(6, 7, 6, 7));
 }
 
+TEST_CASE("finger_map_t")
+{
+    finger_map_t fingers;
+    fingers[5] = finger_in_dir(5, 5);
+    fingers[1] = finger_in_dir(1, 1);
+    fingers[3] = finger_in_dir(3, 3);
+    CHECK(fingers.size() == 3);
+
+    int expected_ids[] = {1, 3, 5};
+    int idx = 0;
+    for (auto& f : fingers)
+    {
+        CHECK(f.first == expected_ids[idx++]);
+    }
+
+    CHECK(fingers.erase(3) == 1);
+    CHECK(fingers.erase(3) == 0);
+    CHECK(fingers.count(3) == 0);
+    CHECK(fingers.find(5)->second.current == point_t{5, 5});
+
+    fingers.clear();
+    for (int i = 0; i < (int)finger_map_t::MAX_FINGERS + 2; i++)
+    {
+        fingers[i] = finger_in_dir(i, i);
+    }
+
+    CHECK(fingers.size() == finger_map_t::MAX_FINGERS);
+    CHECK(fingers.count(finger_map_t::MAX_FINGERS) == 0);
+}
+
+TEST_CASE("gesture_state_t::get_center after updates")
+{
+    gesture_state_t state;
+    gesture_event_t ev;
+    ev.type   = EVENT_TYPE_TOUCH_DOWN;
+    ev.finger = 0;
+    ev.pos    = {0, 0};
+    state.update(ev);
+    ev.finger = 1;
+    ev.pos    = {2, 4};
+    state.update(ev);
+    compare_finger(state.get_center(), finger_2p(1, 2, 1, 2));
+
+    ev.type = EVENT_TYPE_MOTION;
+    ev.pos  = {4, 8};
+    state.update(ev);
+    compare_finger(state.get_center(), finger_2p(1, 2, 2, 4));
+    CHECK(state.get_pinch_scale() == doctest::Approx(2));
+
+    // Fingers modified directly are picked up as well
+    state.fingers[0].current = {2, 2};
+    compare_finger(state.get_center(), finger_2p(1, 2, 3, 5));
+
+    state.reset_origin();
+    compare_finger(state.get_center(), finger_2p(3, 5, 3, 5));
+
+    ev.type   = EVENT_TYPE_TOUCH_UP;
+    ev.finger = 0;
+    state.update(ev);
+    compare_finger(state.get_center(), finger_2p(4, 8, 4, 8));
+}
+
 TEST_CASE("touch_target_t")
 {
     touch_target_t target{-1, 1, 2, 2};
@@ -0,0 +1,48 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+#include "shared.hpp"
+#include <chrono>
+
+// Not part of the unit tests, run with `meson test --benchmark`.
+
+TEST_CASE("gesture_state_t::update benchmark")
+{
+    // Ten fingers moving together, as in a 10-finger swipe or pinch: every motion event updates the state and
+    // queries the values the gesture actions use.
+    constexpr int FINGERS    = 10;
+    constexpr int ITERATIONS = 100000;
+
+    gesture_state_t state;
+    gesture_event_t ev;
+    ev.type = EVENT_TYPE_TOUCH_DOWN;
+    for (int i = 0; i < FINGERS; i++)
+    {
+        ev.finger = i;
+        ev.pos    = {i * 10.0, 0};
+        state.update(ev);
+    }
+
+    double sink = 0;
+    ev.type = EVENT_TYPE_MOTION;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 1; it <= ITERATIONS; it++)
+    {
+        for (int i = 0; i < FINGERS; i++)
+        {
+            ev.finger = i;
+            ev.pos    = {i * 10.0, it * 0.01};
+            state.update(ev);
+            sink += state.get_center().current.y + state.get_pinch_scale() + state.get_rotation_angle();
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    MESSAGE("gesture_state_t::update: ", elapsed / (ITERATIONS * FINGERS), " ns per event");
+
+    CHECK(sink > 0);
+    CHECK(state.fingers.size() == FINGERS);
+    auto center = state.get_center();
+    CHECK(center.origin.x == doctest::Approx(45));
+    CHECK(center.current.y == doctest::Approx(ITERATIONS * 0.01));
+}
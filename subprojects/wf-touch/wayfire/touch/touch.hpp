@@ -15,6 +15,7 @@
  * either all actions are completed or an action cancels the gesture.
  */
 #include <glm/vec2.hpp>
+#include <array>
 #include <vector>
 #include <map>
 #include <memory>
@@ -85,6 +86,57 @@ struct gesture_event_t
     point_t pos{};
 };
 
+/**
+ * The fingers currently on the screen, indexed by their id.
+ *
+ * The fingers are kept in a fixed-capacity array sorted by id, so that tracking them never allocates. The
+ * interface mirrors the subset of std::map<int, finger_t> used on the gesture state: iterating yields
+ * (id, finger) pairs in ascending id order. Touch points beyond MAX_FINGERS are not tracked.
+ */
+class finger_map_t
+{
+  public:
+    static constexpr size_t MAX_FINGERS = 16;
+
+    using value_type     = std::pair<int, finger_t>;
+    using iterator       = value_type*;
+    using const_iterator = const value_type*;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    size_t size() const;
+    bool empty() const;
+    size_t count(int id) const;
+
+    iterator find(int id);
+    const_iterator find(int id) const;
+
+    /**
+     * Get the finger with the given id, adding it if it is not tracked yet. If all slots are taken, a
+     * scratch finger which is not part of the map is returned.
+     */
+    finger_t& operator [](int id);
+
+    /** Remove the finger with the given id. @return The number of removed fingers. */
+    size_t erase(int id);
+    void clear();
+
+    /**
+     * A counter which changes whenever the fingers may have been modified, that is, on every non-const
+     * access to the map.
+     */
+    uint64_t get_version() const;
+
+  private:
+    std::array<value_type, MAX_FINGERS> slots;
+    size_t nr_fingers = 0;
+    uint64_t version  = 0;
+    finger_t overflow;
+};
+
 /**
  * Contains all fingers.
  */
@@ -92,7 +144,7 @@ struct gesture_state_t
 {
   public:
     // finger_id -> finger_t
-    std::map<int, finger_t> fingers;
+    finger_map_t fingers;
 
     /** Update fingers based on the event */
     void update(const gesture_event_t& event);
@@ -111,6 +163,28 @@ struct gesture_state_t
      * NB: Works only for rotation < 180 degrees.
      */
     double get_rotation_angle() const;
+
+  private:
+    /**
+     * Values derived from the fingers, valid as long as the fingers have not changed since @version.
+     * The sums of the finger positions are updated incrementally by update() and reset_origin(), the pinch
+     * scale and rotation angle are computed at most once per change.
+     */
+    struct derived_t
+    {
+        uint64_t version = (uint64_t)-1;
+        point_t origin_sum{};
+        point_t current_sum{};
+        std::optional<double> pinch_scale;
+        std::optional<double> rotation_angle;
+    };
+
+    mutable derived_t derived;
+
+    /** Recompute the derived values if the fingers were modified directly. */
+    void sync_derived() const;
+    /** Add (sign = 1) or remove (sign = -1) the finger with the given id to/from the position sums. */
+    void add_finger_to_derived(int id, double sign);
 };
 
 /**
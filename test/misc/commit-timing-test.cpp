@@ -0,0 +1,36 @@
+#include "core/commit-timing.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+extern "C"
+{
+#include <wlr/backend/headless.h>
+}
+
+TEST_CASE("choose_commit_timing_output picks the fastest output")
+{
+    wl_display *display = wl_display_create();
+    wlr_backend *backend = wlr_headless_backend_create(wl_display_get_event_loop(display));
+    REQUIRE(backend != nullptr);
+
+    wlr_output *slow = wlr_headless_add_output(backend, 1920, 1080);
+    wlr_output *fast = wlr_headless_add_output(backend, 1920, 1080);
+    REQUIRE(slow != nullptr);
+    REQUIRE(fast != nullptr);
+    slow->refresh = 60000;
+    fast->refresh = 144000;
+
+    CHECK(wf::choose_commit_timing_output({}) == nullptr);
+    CHECK(wf::choose_commit_timing_output({slow}) == slow);
+    CHECK(wf::choose_commit_timing_output({slow, fast}) == fast);
+    CHECK(wf::choose_commit_timing_output({fast, slow}) == fast);
+
+    // Outputs with an unknown refresh rate are only used if there is nothing else.
+    fast->refresh = 0;
+    CHECK(wf::choose_commit_timing_output({fast, slow}) == slow);
+    slow->refresh = 0;
+    CHECK(wf::choose_commit_timing_output({fast, slow}) == fast);
+
+    wlr_backend_destroy(backend);
+    wl_display_destroy(display);
+}
@@ -0,0 +1,106 @@
+#include "core/core-impl.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/img.hpp>
+#include <wayfire/worker-pool.hpp>
+#include <wayfire/signal-provider.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/util/log.hpp>
+#include <iostream>
+#include <unistd.h>
+
+static void setup_core()
+{
+    static bool initialized = false;
+    if (initialized)
+    {
+        return;
+    }
+
+    initialized = true;
+    wf::log::initialize_logging(std::cout, wf::log::LOG_LEVEL_DEBUG, wf::log::LOG_COLOR_MODE_OFF);
+    auto& core = wf::compositor_core_impl_t::allocate_core();
+    core.ev_loop = wl_event_loop_create();
+    wf::wl_idle_call::loop = core.ev_loop;
+    core.workers = std::make_unique<wf::worker_pool_t>();
+    image_io::init();
+}
+
+static std::vector<uint8_t> make_pixels(int w, int h)
+{
+    std::vector<uint8_t> pixels((size_t)w * h * 4);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        // Opaque, so that the decoded pixels match exactly.
+        pixels[i] = (i % 4 == 3) ? 255 : (i * 7) % 251;
+    }
+
+    return pixels;
+}
+
+TEST_CASE("write_to_file_async round-trips pixels through the PNG encoder")
+{
+    setup_core();
+    constexpr int WIDTH  = 37;
+    constexpr int HEIGHT = 23;
+    const auto expected = make_pixels(WIDTH, HEIGHT);
+
+    std::vector<image_io::write_done_signal> written;
+    wf::signal::connection_t<image_io::write_done_signal> on_write_done =
+        [&] (image_io::write_done_signal *ev)
+    {
+        written.push_back(*ev);
+    };
+    wf::get_core().connect(&on_write_done);
+
+    for (int level : {image_io::COMPRESSION_NONE, image_io::COMPRESSION_FAST})
+    {
+        CAPTURE(level);
+        char dir[] = "/tmp/wf-image-io-test-XXXXXX";
+        REQUIRE(mkdtemp(dir));
+        const std::string name = std::string(dir) + "/image.png";
+
+        written.clear();
+        image_io::write_to_file_async(name, expected, WIDTH, HEIGHT, level);
+        CHECK(written.empty());
+        wf::get_core().workers->flush();
+        REQUIRE(written.size() == 1);
+        CHECK(written[0].name == name);
+        CHECK(written[0].success);
+
+        image_io::decoded_image_ptr decoded;
+        image_io::load_from_file_async(name, [&] (image_io::decoded_image_ptr image)
+        {
+            decoded = image;
+        });
+        wf::get_core().workers->flush();
+        REQUIRE(decoded);
+        CHECK(decoded->width == WIDTH);
+        CHECK(decoded->height == HEIGHT);
+        CHECK(decoded->channels == 4);
+        CHECK(decoded->pixels == expected);
+
+        unlink(name.c_str());
+        rmdir(dir);
+    }
+}
+
+TEST_CASE("write_to_file_async reports failures")
+{
+    setup_core();
+    std::vector<image_io::write_done_signal> written;
+    wf::signal::connection_t<image_io::write_done_signal> on_write_done =
+        [&] (image_io::write_done_signal *ev)
+    {
+        written.push_back(*ev);
+    };
+    wf::get_core().connect(&on_write_done);
+
+    image_io::write_to_file_async("/nonexistent/image.png", make_pixels(4, 4), 4, 4,
+        image_io::COMPRESSION_FAST);
+    wf::get_core().workers->flush();
+    REQUIRE(written.size() == 1);
+    CHECK(written[0].name == "/nonexistent/image.png");
+    CHECK(!written[0].success);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <drm_fourcc.h>
+#include <vector>
+
+extern "C"
+{
+#include <wlr/interfaces/wlr_buffer.h>
+}
+
+/** A wlr_buffer in main memory, like a shm client buffer or a pixman output buffer. */
+struct memory_buffer_t
+{
+    wlr_buffer base;
+    std::vector<uint32_t> pixels;
+
+    memory_buffer_t(int width, int height, uint32_t fill) : pixels((size_t)width * height, fill)
+    {
+        wlr_buffer_init(&base, &impl, width, height);
+    }
+
+    ~memory_buffer_t()
+    {
+        wlr_buffer_finish(&base);
+    }
+
+    static bool begin_access(wlr_buffer *buffer, uint32_t flags, void **data, uint32_t *format,
+        size_t *stride)
+    {
+        memory_buffer_t *self = wl_container_of(buffer, self, base);
+        *data   = self->pixels.data();
+        *format = DRM_FORMAT_XRGB8888;
+        *stride = (size_t)buffer->width * 4;
+        return true;
+    }
+
+    static constexpr wlr_buffer_impl impl = {
+        .destroy = [] (wlr_buffer*) {},
+        .begin_data_ptr_access = begin_access,
+        .end_data_ptr_access   = [] (wlr_buffer*) {},
+    };
+};
@@ -0,0 +1,40 @@
+#include "core/output-capture.hpp"
+#include "memory-buffer.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <chrono>
+
+// Not part of the unit tests, run with `meson test --benchmark`.
+
+TEST_CASE("copy_damage_cpu benchmark")
+{
+    // Capturing a 4K output while a terminal-sized area changes, compared to copying the whole frame.
+    constexpr int WIDTH  = 3840;
+    constexpr int HEIGHT = 2160;
+    constexpr int FRAMES = 200;
+    memory_buffer_t src{WIDTH, HEIGHT, 1};
+    memory_buffer_t dst{WIDTH, HEIGHT, 0};
+
+    auto measure = [&] (const wf::region_t& damage, uint64_t& bytes)
+    {
+        bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < FRAMES; i++)
+        {
+            bytes += wf::copy_damage_cpu(&src.base, &dst.base, damage).value_or(0);
+        }
+
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count() / FRAMES;
+    };
+
+    uint64_t full_bytes, damaged_bytes;
+    auto full_us    = measure(wf::region_t{wlr_box{0, 0, WIDTH, HEIGHT}}, full_bytes);
+    auto damaged_us = measure(wf::region_t{wlr_box{100, 100, 800, 600}}, damaged_bytes);
+    MESSAGE("full frame: ", full_us, " us and ", full_bytes / FRAMES, " bytes per frame");
+    MESSAGE("800x600 damage: ", damaged_us, " us and ", damaged_bytes / FRAMES, " bytes per frame");
+
+    CHECK(full_bytes == (uint64_t)FRAMES * WIDTH * HEIGHT * 4);
+    CHECK(damaged_bytes == (uint64_t)FRAMES * 800 * 600 * 4);
+}
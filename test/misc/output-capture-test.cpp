@@ -0,0 +1,26 @@
+#include "core/output-capture.hpp"
+#include "memory-buffer.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+TEST_CASE("copy_damage_cpu copies only the damaged pixels")
+{
+    memory_buffer_t src{100, 100, 1};
+    memory_buffer_t dst{100, 100, 0};
+
+    auto copied = wf::copy_damage_cpu(&src.base, &dst.base, wf::region_t{wlr_box{10, 20, 30, 40}});
+    REQUIRE(copied.has_value());
+    CHECK(*copied == 30 * 40 * 4);
+    CHECK(dst.pixels[20 * 100 + 10] == 1);
+    CHECK(dst.pixels[59 * 100 + 39] == 1);
+    CHECK(dst.pixels[19 * 100 + 10] == 0);
+    CHECK(dst.pixels[20 * 100 + 40] == 0);
+
+    // Damage outside of the buffer is ignored.
+    copied = wf::copy_damage_cpu(&src.base, &dst.base, wf::region_t{wlr_box{90, 90, 50, 50}});
+    REQUIRE(copied.has_value());
+    CHECK(*copied == 10 * 10 * 4);
+
+    memory_buffer_t small{50, 50, 0};
+    CHECK(!wf::copy_damage_cpu(&src.base, &small.base, wf::region_t{wlr_box{0, 0, 10, 10}}).has_value());
+}
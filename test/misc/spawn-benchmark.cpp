@@ -0,0 +1,36 @@
+#include "core/spawn.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Not part of the unit tests, run with `meson test --benchmark`.
+TEST_CASE("spawn_command benchmark")
+{
+    REQUIRE(wf::start_spawn_helper(false));
+
+    // Simulate a compositor with a large resident set, which fork() would have to copy the page tables of for
+    // each launched command. The spawn helper was forked before, so its forks stay cheap.
+    constexpr size_t RESIDENT_BYTES = 512 << 20;
+    constexpr int LAUNCHES = 50;
+    std::vector<char> resident(RESIDENT_BYTES);
+    for (size_t i = 0; i < resident.size(); i += 4096)
+    {
+        resident[i] = 1;
+    }
+
+    // The time spent in spawn_command() is the time the compositor is blocked for.
+    std::vector<std::string> env;
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+    for (int i = 0; i < LAUNCHES; i++)
+    {
+        REQUIRE(wf::spawn_command("true", env, RLIM_INFINITY, true) > 0);
+    }
+
+    auto blocked_us = duration_cast<microseconds>(steady_clock::now() - start).count();
+    MESSAGE("spawn_command with ", RESIDENT_BYTES >> 20, " MiB resident: ", blocked_us / LAUNCHES,
+        " us blocked per launch");
+}
@@ -0,0 +1,63 @@
+#include "core/spawn.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static std::vector<std::string> get_environment()
+{
+    extern char **environ;
+    std::vector<std::string> env;
+    for (char **var = environ; *var; var++)
+    {
+        env.emplace_back(*var);
+    }
+
+    return env;
+}
+
+/** Wait until the command has written a line to the file, it is not our child so it cannot be waited for. */
+static std::string wait_for_line(const std::string& path)
+{
+    std::string line;
+    for (int i = 0; (i < 500) && line.empty(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::ifstream file{path};
+        std::getline(file, line);
+    }
+
+    return line;
+}
+
+TEST_CASE("spawn_command runs the command detached with the given limit and environment")
+{
+    REQUIRE(wf::start_spawn_helper(false));
+
+    char path[] = "/tmp/wf-spawn-test-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    auto env = get_environment();
+    env.push_back("WF_SPAWN_TEST=value");
+    const std::string file = path;
+    const std::string command = "echo $$ $(ulimit -S -n) $WF_SPAWN_TEST > " + file + ".tmp && mv " +
+        file + ".tmp " + file;
+    pid_t pid = wf::spawn_command(command, env, 123, false);
+    REQUIRE(pid > 0);
+
+    // The command is reparented to init instead of becoming our child.
+    CHECK(waitpid(pid, nullptr, WNOHANG) == -1);
+    CHECK(errno == ECHILD);
+
+    CHECK(wait_for_line(path) == std::to_string(pid) + " 123 value");
+    unlink(path);
+}
@@ -0,0 +1,103 @@
+#!/usr/bin/python
+
+# Record an input session with the stipc plugin, or replay a recording and report the frame times and the
+# input-to-frame latency of each run. Talks to the Wayfire instance given by $WAYFIRE_SOCKET.
+#
+# For reproducible results, replay on a headless instance with the same plugins as the recording:
+#   WLR_BACKENDS=headless WLR_RENDERER=pixman wayfire -c bench.ini
+#
+# Usage:
+#   replay-benchmark.py record session.json
+#   replay-benchmark.py replay session.json [--runs 5] [--batch 64 | --realtime]
+#
+# IPC messages are limited to 1 MiB, so recordings are fetched and loaded in chunks of --chunk events.
+
+import argparse
+import json
+import os
+import socket
+import struct
+import time
+
+
+class Connection:
+    def __init__(self, path):
+        self.socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.socket.connect(path)
+
+    def read_exact(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.socket.recv(n - len(data))
+            if not chunk:
+                raise RuntimeError("Wayfire closed the connection")
+            data += chunk
+        return data
+
+    def call(self, method, data={}):
+        message = json.dumps({"method": method, "data": data}).encode("utf-8")
+        self.socket.sendall(struct.pack("=I", len(message)) + message)
+        (length,) = struct.unpack("=I", self.read_exact(4))
+        response = json.loads(self.read_exact(length))
+        if "error" in response:
+            raise RuntimeError(f"{method}: {response['error']}")
+        return response
+
+
+def record(conn, args):
+    conn.call("stipc/record/start")
+    input("Recording, press Enter to stop...")
+    total = conn.call("stipc/record/stop")["count"]
+    events = []
+    while len(events) < total:
+        events += conn.call("stipc/record/events", {"offset": len(events), "count": args.chunk})["events"]
+    with open(args.recording, "w") as f:
+        json.dump(events, f)
+    print(f"Recorded {len(events)} events to {args.recording}")
+
+
+def replay(conn, args):
+    with open(args.recording) as f:
+        events = json.load(f)
+
+    chunks = [events[i:i + args.chunk] for i in range(0, len(events), args.chunk)] or [[]]
+    for run in range(args.runs):
+        for chunk in chunks[:-1]:
+            conn.call("stipc/replay", {"events": chunk, "append": True})
+
+        start = time.monotonic()
+        conn.call("stipc/replay", {"events": chunks[-1], "realtime": args.realtime, "batch": args.batch})
+        while not (stats := conn.call("stipc/replay/stats"))["done"]:
+            time.sleep(0.05)
+
+        elapsed = time.monotonic() - start
+        frames = stats["frame-time-us"]
+        latency = stats["input-latency-us"]
+        print(f"run {run + 1}: {stats['events']} events in {elapsed:.2f}s, {stats['frames']} frames, "
+              f"{stats['errors']} errors")
+        if frames:
+            print(f"  frame time us:    avg {frames['avg']} p50 {frames['p50']} p95 {frames['p95']} "
+                  f"max {frames['max']}")
+        if latency:
+            print(f"  input latency us: avg {latency['avg']} p50 {latency['p50']} p95 {latency['p95']} "
+                  f"max {latency['max']}")
+
+
+parser = argparse.ArgumentParser(description="Record and replay input sessions through stipc")
+subparsers = parser.add_subparsers(dest="command", required=True)
+record_parser = subparsers.add_parser("record")
+record_parser.add_argument("recording")
+record_parser.add_argument("--chunk", type=int, default=4096, help="events fetched per request")
+replay_parser = subparsers.add_parser("replay")
+replay_parser.add_argument("recording")
+replay_parser.add_argument("--chunk", type=int, default=4096, help="events sent per request")
+replay_parser.add_argument("--runs", type=int, default=1)
+replay_parser.add_argument("--batch", type=int, default=64, help="events dispatched per 1ms tick")
+replay_parser.add_argument("--realtime", action="store_true", help="keep the recorded timing")
+args = parser.parse_args()
+
+conn = Connection(os.environ["WAYFIRE_SOCKET"])
+if args.command == "record":
+    record(conn, args)
+else:
+    replay(conn, args)